@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/backend.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+#include <fmt/format.h>
+#include <httplib.h>
+#include <range/v3/algorithm/all_of.hpp>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+namespace lint::cache {
+  namespace fs = std::filesystem;
+
+  namespace {
+    // Remote lookups are made for each file, so a slow server shouldn't
+    // cost more than checking the file.
+    constexpr auto connection_timeout = std::chrono::seconds{2};
+    constexpr auto read_timeout       = std::chrono::seconds{10};
+
+    auto make_client(const std::string &host) -> httplib::Client {
+      auto client = httplib::Client{host};
+      client.set_connection_timeout(connection_timeout);
+      client.set_read_timeout(read_timeout);
+      return client;
+    }
+
+    auto make_headers(const std::string &token) -> httplib::Headers {
+      auto headers = httplib::Headers{};
+      if (!token.empty()) {
+        headers.emplace("Authorization", fmt::format("Bearer {}", token));
+      }
+      return headers;
+    }
+  } // namespace
+
+  auto is_valid_key(const std::string &key) -> bool {
+    auto is_hex = [](char chr) { return (chr >= '0' && chr <= '9') || (chr >= 'a' && chr <= 'f'); };
+    return key.size() > 2 && ranges::all_of(key, is_hex);
+  }
+
+  directory_backend::directory_backend(std::string dir)
+    : dir_(std::move(dir)) {
+  }
+
+  auto directory_backend::path_of(const std::string &key) const -> std::string {
+    // Spread entries into sub directories, like .git/objects.
+    return fmt::format("{}/{}/{}.json", dir_, key.substr(0, 2), key.substr(2));
+  }
+
+  auto directory_backend::get(const std::string &key) -> std::optional<std::string> {
+    auto file = std::ifstream{path_of(key), std::ios::binary};
+    if (!file.is_open()) {
+      return std::nullopt;
+    }
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  }
+
+  void directory_backend::put(const std::string &key, const std::string &value) {
+    auto path = fs::path{path_of(key)};
+    auto ec   = std::error_code{};
+    fs::create_directories(path.parent_path(), ec);
+
+    // Write to a unique temporary file first, so that concurrent writers and
+    // readers never observe a partially written entry.
+    auto temp  = path;
+    temp      += fmt::format(".{}.{}.tmp",
+                        ::getpid(),
+                        std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+      auto file = std::ofstream{temp, std::ios::binary};
+      if (!file.is_open()) {
+        spdlog::warn("failed to write cache entry {}", path.string());
+        return;
+      }
+      file << value;
+    }
+    fs::rename(temp, path, ec);
+    if (ec) {
+      spdlog::warn("failed to write cache entry {}: {}", path.string(), ec.message());
+      fs::remove(temp, ec);
+    }
+  }
+
+  http_backend::http_backend(std::string url, std::string token)
+    : token_(std::move(token)) {
+    // Split "http://host:port/base" into the host part and the base path.
+    auto scheme = url.find("://");
+    auto slash  = url.find('/', scheme == std::string::npos ? 0 : scheme + 3);
+    host_       = url.substr(0, slash);
+    if (slash != std::string::npos) {
+      base_path_ = url.substr(slash);
+    }
+    while (base_path_.ends_with('/')) {
+      base_path_.pop_back();
+    }
+  }
+
+  auto http_backend::get(const std::string &key) -> std::optional<std::string> {
+    if (unreachable_) {
+      return std::nullopt;
+    }
+    auto client = make_client(host_);
+
+    auto response = client.Get(fmt::format("{}/{}", base_path_, key), make_headers(token_));
+    if (!response) {
+      spdlog::warn("remote result cache {} is unreachable: {}",
+                   host_,
+                   httplib::to_string(response.error()));
+      unreachable_ = true;
+      return std::nullopt;
+    }
+    if (response->status != httplib::StatusCode::OK_200) {
+      if (response->status != httplib::StatusCode::NotFound_404) {
+        spdlog::debug("remote result cache returns {} for {}", response->status, key);
+      }
+      return std::nullopt;
+    }
+    return std::move(response->body);
+  }
+
+  void http_backend::put(const std::string &key, const std::string &value) {
+    if (unreachable_) {
+      return;
+    }
+    auto client = make_client(host_);
+
+    auto response = client.Put(
+      fmt::format("{}/{}", base_path_, key), make_headers(token_), value, "application/json");
+    if (!response) {
+      spdlog::warn("remote result cache {} is unreachable: {}",
+                   host_,
+                   httplib::to_string(response.error()));
+      unreachable_ = true;
+      return;
+    }
+    if (response->status / 100 != 2) {
+      spdlog::warn("failed to store {} into remote result cache: {}", key, response->status);
+    }
+  }
+
+} // namespace lint::cache
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace lint::cache {
+  /// A store of cache entries. Keys are hex strings made by key_builder.
+  /// Implementations must be thread safe, and log failures instead of
+  /// throwing them, since the cache only saves time.
+  struct backend_base {
+    virtual ~backend_base() = default;
+
+    /// Return the entry of the key, or std::nullopt on miss.
+    virtual auto get(const std::string &key) -> std::optional<std::string> = 0;
+
+    /// Store the entry of the key.
+    virtual void put(const std::string &key, const std::string &value) = 0;
+  };
+
+  using backend_base_ptr = std::unique_ptr<backend_base>;
+
+  /// Entries stored one file per key under a local directory.
+  class directory_backend : public backend_base {
+  public:
+    explicit directory_backend(std::string dir);
+
+    auto get(const std::string &key) -> std::optional<std::string> override;
+
+    void put(const std::string &key, const std::string &value) override;
+
+  private:
+    [[nodiscard]] auto path_of(const std::string &key) const -> std::string;
+
+    std::string dir_;
+  };
+
+  /// Entries stored by a remote cache server, such as cpp-lint-action-cache-server.
+  /// `GET <url>/<key>` returns the entry or 404, and `PUT <url>/<key>` stores
+  /// it. The server is skipped for the rest of the run after it's unreachable
+  /// once, so a down server costs one timeout only.
+  class http_backend : public backend_base {
+  public:
+    /// The token is sent as a bearer token if it isn't empty.
+    http_backend(std::string url, std::string token);
+
+    auto get(const std::string &key) -> std::optional<std::string> override;
+
+    void put(const std::string &key, const std::string &value) override;
+
+  private:
+    std::string host_;
+    std::string base_path_;
+    std::string token_;
+    std::atomic<bool> unreachable_{false};
+  };
+
+  /// Whether the key is a well-formed cache key, which is safe to be used as
+  /// a file name or an url path.
+  auto is_valid_key(const std::string &key) -> bool;
+
+} // namespace lint::cache
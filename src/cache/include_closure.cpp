@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/include_closure.h"
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+
+#include <nlohmann/json.hpp>
+#include <range/v3/algorithm/all_of.hpp>
+#include <range/v3/algorithm/contains.hpp>
+#include <spdlog/spdlog.h>
+
+#include "utils/common.h"
+#include "utils/error.h"
+#include "utils/git_utils.h"
+#include "utils/shell.h"
+
+namespace lint::cache {
+  namespace fs = std::filesystem;
+  using namespace std::string_view_literals;
+
+  namespace {
+    auto normalize(const fs::path &dir, const std::string &file) -> std::string {
+      return (dir / file).lexically_normal().string();
+    }
+
+    // Normalize a directory without the trailing separator, so that it can be
+    // compared by path elements.
+    auto normalize_dir(const std::string &dir) -> fs::path {
+      auto path = fs::path{dir}.lexically_normal().string();
+      while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+      }
+      return path;
+    }
+
+    // Whether the normalized path is the directory or under it.
+    auto is_under(const fs::path &path, const fs::path &dir) -> bool {
+      if (dir.empty()) {
+        return false;
+      }
+      auto relative = path.lexically_relative(dir);
+      return !relative.empty() && *relative.begin() != "..";
+    }
+
+    constexpr auto include_dir_options = {"-I"sv, "-iquote"sv, "-isystem"sv, "-idirafter"sv};
+
+    // Return the include directory option which the argument starts with.
+    auto find_include_option(std::string_view arg) -> std::optional<std::string_view> {
+      for (auto option: include_dir_options) {
+        if (arg.starts_with(option)) {
+          return option;
+        }
+      }
+      return std::nullopt;
+    }
+
+    // Options which produce outputs. They're dropped from preprocessor runs so
+    // that they neither write files nor compile.
+    constexpr auto dropped_options = {"-c"sv, "-M"sv, "-MM"sv, "-MD"sv, "-MMD"sv, "-MP"sv, "-MG"sv};
+    constexpr auto dropped_valued_options = {"-o"sv, "-MF"sv, "-MT"sv, "-MQ"sv};
+
+    // Make the options which run the compiler in the given preprocessor mode,
+    // such as -M or -E. Outputs are written to stdout.
+    auto make_preprocess_options(const std::vector<std::string> &arguments,
+                                 std::initializer_list<std::string_view> mode)
+      -> std::vector<std::string> {
+      auto opts = std::vector<std::string>{};
+      for (std::size_t i = 1; i < arguments.size(); ++i) {
+        const auto &arg = arguments[i];
+        if (ranges::contains(dropped_options, arg)) {
+          continue;
+        }
+        if (ranges::contains(dropped_valued_options, arg)) {
+          ++i;
+          continue;
+        }
+        if (arg.starts_with("-MF") || arg.starts_with("-MT") || arg.starts_with("-MQ")) {
+          continue;
+        }
+        opts.push_back(arg);
+      }
+      opts.insert(opts.end(), mode.begin(), mode.end());
+      return opts;
+    }
+
+    // Resolve the compiler like a shell does.
+    auto find_compiler(const std::string &compiler, const std::string &directory)
+      -> std::optional<std::string> {
+      if (compiler.find('/') != std::string::npos) {
+        return normalize(directory, compiler);
+      }
+      auto [ec, std_out, std_err] = shell::which(compiler);
+      if (ec != 0) {
+        return std::nullopt;
+      }
+      auto trimmed = trim(std_out);
+      return std::string{trimmed.data(), trimmed.size()};
+    }
+
+    // Run the compiler of the command in the given preprocessor mode and
+    // return its stdout.
+    auto preprocess(const compile_command &command, std::initializer_list<std::string_view> mode)
+      -> std::optional<std::string> {
+      auto compiler = find_compiler(command.arguments.front(), command.directory);
+      if (!compiler) {
+        spdlog::debug("can't find compiler {} of {}", command.arguments.front(), command.file);
+        return std::nullopt;
+      }
+
+      auto opts = make_preprocess_options(command.arguments, mode);
+      auto res  = shell::execute(*compiler, opts, command.directory);
+      if (res.exit_code != 0) {
+        spdlog::debug("preprocess {} by {} failed: {}", command.file, *mode.begin(), res.std_err);
+        return std::nullopt;
+      }
+      return std::move(res.std_out);
+    }
+  } // namespace
+
+  auto compile_database::load(const std::string &build_dir) -> std::optional<compile_database> {
+    auto file = std::ifstream{fs::path{build_dir} / "compile_commands.json"};
+    if (!file.is_open()) {
+      return std::nullopt;
+    }
+    auto json = nlohmann::json::parse(file, nullptr, false);
+    if (!json.is_array()) {
+      spdlog::debug("ignore broken compilation database in {}", build_dir);
+      return std::nullopt;
+    }
+
+    auto database = compile_database{};
+    for (const auto &entry: json) {
+      if (!entry.is_object() || !entry.contains("directory") || !entry.contains("file")) {
+        continue;
+      }
+      auto command      = compile_command{};
+      command.directory = entry["directory"].get<std::string>();
+      command.file      = entry["file"].get<std::string>();
+      if (entry.contains("arguments")) {
+        command.arguments = entry["arguments"].get<std::vector<std::string>>();
+      } else if (entry.contains("command")) {
+        command.arguments = split_command(entry["command"].get<std::string>());
+      }
+      if (command.arguments.empty()) {
+        continue;
+      }
+      auto path = normalize(command.directory, command.file);
+      database.commands_.try_emplace(std::move(path), std::move(command));
+    }
+    return database;
+  }
+
+  auto compile_database::find(const std::string &file) const -> const compile_command * {
+    auto iter = commands_.find(fs::path{file}.lexically_normal().string());
+    return iter == commands_.end() ? nullptr : &iter->second;
+  }
+
+  auto compile_database::relocate(const std::string &from,
+                                  const std::string &to,
+                                  const std::string &kept) const -> compile_database {
+    auto database = compile_database{};
+    for (const auto &[file, command]: commands_) {
+      auto moved = cache::relocate(command, from, to, kept);
+      auto path  = normalize(moved.directory, moved.file);
+      database.commands_.try_emplace(std::move(path), std::move(moved));
+    }
+    return database;
+  }
+
+  void compile_database::save(const std::string &build_dir) const {
+    auto json = nlohmann::json::array();
+    for (const auto &[file, command]: commands_) {
+      json.push_back({
+        {"directory", command.directory},
+        {"file",      command.file     },
+        {"arguments", command.arguments}
+      });
+    }
+    auto path = fs::path{build_dir} / "compile_commands.json";
+    auto file = std::ofstream{path};
+    throw_unless(file.is_open(), fmt::format("failed to write {}", path.string()));
+    file << json.dump();
+  }
+
+  auto include_dirs(const compile_command &command) -> std::vector<std::string> {
+    auto dirs       = std::vector<std::string>{};
+    const auto &arg = command.arguments;
+    for (std::size_t i = 1; i < arg.size(); ++i) {
+      auto option = find_include_option(arg[i]);
+      if (!option) {
+        continue;
+      }
+      if (arg[i].size() != option->size()) {
+        dirs.push_back(normalize(command.directory, arg[i].substr(option->size())));
+      } else if (i + 1 < arg.size()) {
+        dirs.push_back(normalize(command.directory, arg[++i]));
+      }
+    }
+    return dirs;
+  }
+
+  auto relocate(const compile_command &command,
+                const std::string &from,
+                const std::string &to,
+                const std::string &kept) -> compile_command {
+    auto from_dir = normalize_dir(from);
+    auto to_dir   = normalize_dir(to);
+    auto kept_dir = kept.empty() ? fs::path{} : normalize_dir(kept);
+    auto move_path = [&](const std::string &path) -> std::string {
+      auto normalized = normalize_dir(path);
+      if (!is_under(normalized, from_dir) || is_under(normalized, kept_dir)) {
+        return normalized.string();
+      }
+      auto relative = normalized.lexically_relative(from_dir);
+      return relative == "." ? to_dir.string() : (to_dir / relative).string();
+    };
+
+    auto source     = normalize(command.directory, command.file);
+    auto moved      = compile_command{};
+    moved.directory = move_path(command.directory);
+    moved.file      = move_path(source);
+
+    const auto &arg = command.arguments;
+    moved.arguments.push_back(arg.front());
+    for (std::size_t i = 1; i < arg.size(); ++i) {
+      if (auto option = find_include_option(arg[i])) {
+        if (arg[i].size() != option->size()) {
+          auto dir = normalize(command.directory, arg[i].substr(option->size()));
+          moved.arguments.push_back(fmt::format("{}{}", *option, move_path(dir)));
+        } else {
+          moved.arguments.push_back(arg[i]);
+          if (i + 1 < arg.size()) {
+            moved.arguments.push_back(move_path(normalize(command.directory, arg[++i])));
+          }
+        }
+      } else if (!arg[i].starts_with('-') && normalize(command.directory, arg[i]) == source) {
+        moved.arguments.push_back(moved.file);
+      } else {
+        moved.arguments.push_back(arg[i]);
+      }
+    }
+    return moved;
+  }
+
+  auto split_command(std::string_view command) -> std::vector<std::string> {
+    auto arguments = std::vector<std::string>{};
+    auto current   = std::string{};
+    auto in_token  = false;
+    auto quote     = '\0';
+    for (std::size_t i = 0; i < command.size(); ++i) {
+      auto chr = command[i];
+      if (quote == '\'') {
+        if (chr == '\'') {
+          quote = '\0';
+        } else {
+          current += chr;
+        }
+      } else if (quote == '"') {
+        if (chr == '"') {
+          quote = '\0';
+        } else if (chr == '\\' && i + 1 < command.size()
+                   && (command[i + 1] == '"' || command[i + 1] == '\\')) {
+          current += command[++i];
+        } else {
+          current += chr;
+        }
+      } else if (std::isspace(static_cast<unsigned char>(chr)) != 0) {
+        if (in_token) {
+          arguments.push_back(std::move(current));
+          current.clear();
+          in_token = false;
+        }
+      } else {
+        in_token = true;
+        if (chr == '\'' || chr == '"') {
+          quote = chr;
+        } else if (chr == '\\' && i + 1 < command.size()) {
+          current += command[++i];
+        } else {
+          current += chr;
+        }
+      }
+    }
+    if (in_token) {
+      arguments.push_back(std::move(current));
+    }
+    return arguments;
+  }
+
+  auto parse_make_rule(std::string_view rule) -> std::vector<std::string> {
+    // The target ends at the first colon followed by a space or a line end.
+    auto start = std::size_t{0};
+    while (start < rule.size()) {
+      auto at_end = start + 1 == rule.size()
+                 || std::isspace(static_cast<unsigned char>(rule[start + 1])) != 0;
+      if (rule[start] == ':' && at_end) {
+        break;
+      }
+      ++start;
+    }
+
+    auto files   = std::vector<std::string>{};
+    auto current = std::string{};
+    auto flush   = [&] {
+      if (!current.empty()) {
+        files.push_back(std::move(current));
+        current.clear();
+      }
+    };
+    for (auto i = start + 1; i < rule.size(); ++i) {
+      auto chr = rule[i];
+      if (chr == '\\' && i + 1 < rule.size() && (rule[i + 1] == '\n' || rule[i + 1] == '\r')) {
+        // Line continuation.
+        flush();
+        i += rule[i + 1] == '\r' && i + 2 < rule.size() && rule[i + 2] == '\n' ? 2 : 1;
+      } else if (chr == '\\' && i + 1 < rule.size() && rule[i + 1] == ' ') {
+        current += rule[++i];
+      } else if (chr == '$' && i + 1 < rule.size() && rule[i + 1] == '$') {
+        current += rule[++i];
+      } else if (chr == '\n') {
+        // The rule ends. Others are phony targets.
+        break;
+      } else if (std::isspace(static_cast<unsigned char>(chr)) != 0) {
+        flush();
+      } else {
+        current += chr;
+      }
+    }
+    flush();
+    return files;
+  }
+
+  auto file_hasher::hash(const std::string &path) -> std::string {
+    {
+      auto lock = std::lock_guard{mutex_};
+      if (auto iter = hashes_.find(path); iter != hashes_.end()) {
+        return iter->second;
+      }
+    }
+
+    auto hex  = std::string{};
+    auto file = std::ifstream{path, std::ios::binary};
+    if (file.is_open()) {
+      auto content = std::string{std::istreambuf_iterator<char>{file},
+                                 std::istreambuf_iterator<char>{}};
+      hex          = git::oid::to_str(git::odb::hash(content, GIT_OBJECT_BLOB)).c_str();
+    }
+
+    auto lock = std::lock_guard{mutex_};
+    return hashes_.try_emplace(path, std::move(hex)).first->second;
+  }
+
+  auto scan_include_closure(const compile_command &command,
+                            file_hasher &hasher,
+                            const std::string &root) -> std::optional<include_closure> {
+    auto rule = preprocess(command, {"-M"});
+    if (!rule) {
+      return std::nullopt;
+    }
+
+    auto root_dir = root.empty() ? fs::path{} : normalize_dir(root);
+    auto closure  = include_closure{};
+    for (const auto &file: parse_make_rule(*rule)) {
+      auto path = normalize(command.directory, file);
+      auto hash = hasher.hash(path);
+      if (hash.empty()) {
+        return std::nullopt;
+      }
+      if (is_under(path, root_dir)) {
+        path = fs::path{path}.lexically_relative(root_dir).string();
+      }
+      closure.emplace(std::move(path), std::move(hash));
+    }
+    return closure;
+  }
+
+  auto hash_preprocessed(const compile_command &command, const std::string &root)
+    -> std::optional<std::string> {
+    // Comments are kept, since NOLINT comments of headers change results.
+    auto source = preprocess(command, {"-E", "-C"});
+    if (!source) {
+      return std::nullopt;
+    }
+    // Line markers name included files by their paths.
+    if (!root.empty()) {
+      auto prefix = normalize_dir(root).string() + '/';
+      for (auto pos = source->find(prefix); pos != std::string::npos;
+           pos      = source->find(prefix, pos)) {
+        source->erase(pos, prefix.size());
+      }
+    }
+    return git::oid::to_str(git::odb::hash(*source, GIT_OBJECT_BLOB)).c_str();
+  }
+
+  auto is_unchanged(const include_closure &closure, file_hasher &hasher, const std::string &root)
+    -> bool {
+    return ranges::all_of(closure, [&](const auto &entry) {
+      auto path = fs::path{entry.first};
+      if (path.is_relative()) {
+        path = fs::path{root} / path;
+      }
+      return hasher.hash(path.string()) == entry.second;
+    });
+  }
+
+} // namespace lint::cache
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lint::cache {
+  /// One entry of a compilation database.
+  struct compile_command {
+    std::string directory;
+    std::string file;
+    std::vector<std::string> arguments;
+  };
+
+  /// The compile commands of compile_commands.json, looked up by file.
+  class compile_database {
+  public:
+    /// Load compile_commands.json in the given build directory. Return
+    /// std::nullopt if it's missing or broken.
+    static auto load(const std::string &build_dir) -> std::optional<compile_database>;
+
+    /// Return the compile command of the file, or nullptr if there isn't one.
+    [[nodiscard]] auto find(const std::string &file) const -> const compile_command *;
+
+    /// Return a database of all commands relocated by relocate().
+    [[nodiscard]] auto relocate(const std::string &from,
+                                const std::string &to,
+                                const std::string &kept) const -> compile_database;
+
+    /// Write compile_commands.json into the given build directory.
+    void save(const std::string &build_dir) const;
+
+  private:
+    // Keyed by the normalized absolute path of files.
+    std::unordered_map<std::string, compile_command> commands_;
+  };
+
+  /// Return include directories of the compile command as normalized absolute
+  /// paths, in the order they're searched.
+  auto include_dirs(const compile_command &command) -> std::vector<std::string>;
+
+  /// Move paths of the compile command under `from` to the same paths under
+  /// `to`, except paths under `kept`, such as the build directory. The
+  /// directory, the file, the source argument and include directories are
+  /// moved. Moved paths are absolute.
+  auto relocate(const compile_command &command,
+                const std::string &from,
+                const std::string &to,
+                const std::string &kept) -> compile_command;
+
+  /// Split a shell command line into arguments, like compile_commands.json
+  /// consumers do for the "command" field.
+  auto split_command(std::string_view command) -> std::vector<std::string>;
+
+  /// Parse a make style dependency rule printed by `-M`. Return all
+  /// prerequisites, including the source file itself.
+  auto parse_make_rule(std::string_view rule) -> std::vector<std::string>;
+
+  /// Content hashes of files, each file is hashed at most once per run. It's
+  /// thread safe.
+  class file_hasher {
+  public:
+    /// Return the hex git blob id of the file, or an empty string if the file
+    /// can't be read.
+    auto hash(const std::string &path) -> std::string;
+
+  private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::string> hashes_;
+  };
+
+  /// All files included by a translation unit and their content hashes.
+  using include_closure = std::map<std::string, std::string>;
+
+  /// Capture the include closure of the compile command by running its
+  /// compiler with `-M`. Files under `root` are recorded relative to it, so
+  /// the closure still applies if the files are written somewhere else.
+  /// Return std::nullopt if the scan fails.
+  auto scan_include_closure(const compile_command &command,
+                            file_hasher &hasher,
+                            const std::string &root = {}) -> std::optional<include_closure>;
+
+  /// Hash the preprocessed source of the compile command by running its
+  /// compiler with `-E -C`, which keeps comments such as NOLINT. Paths under
+  /// `root` are hashed relative to it, like the files of an include closure.
+  /// Return std::nullopt if preprocessing fails.
+  auto hash_preprocessed(const compile_command &command, const std::string &root = {})
+    -> std::optional<std::string>;
+
+  /// Whether all files of the closure still have the recorded hashes.
+  /// Relative files are resolved against `root`.
+  auto is_unchanged(const include_closure &closure,
+                    file_hasher &hasher,
+                    const std::string &root = {}) -> bool;
+
+} // namespace lint::cache
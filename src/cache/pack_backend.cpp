@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/pack_backend.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <range/v3/algorithm/sort.hpp>
+#include <spdlog/spdlog.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lint::cache {
+  namespace fs = std::filesystem;
+
+  namespace {
+    constexpr auto pack_name  = "results.pack";
+    constexpr auto index_name = "results.idx";
+
+    using magic_t              = std::array<char, 8>;
+    constexpr auto pack_magic  = magic_t{'C', 'L', 'A', 'P', 'A', 'C', 'K', '1'};
+    constexpr auto index_magic = magic_t{'C', 'L', 'A', 'I', 'D', 'X', '0', '1'};
+
+    // Keys are hex SHA-1 strings, which are stored as raw bytes.
+    constexpr auto key_size = std::size_t{20};
+    using raw_key           = std::array<std::uint8_t, key_size>;
+
+    constexpr auto initial_capacity = std::uint64_t{1024};
+
+    // The index grows when it's more than 70% full, so probes stay short.
+    constexpr auto max_load_percent = std::uint64_t{70};
+
+    // Compaction keeps 80% of the size cap, so it doesn't run again soon.
+    constexpr auto compact_percent = std::uint64_t{80};
+
+    // Each record of the pack is a raw key, the value size and the value.
+    struct record_header {
+      raw_key key;
+      std::uint32_t size;
+    };
+    constexpr auto record_header_size = sizeof(record_header);
+
+    auto to_raw_key(const std::string &key) -> std::optional<raw_key> {
+      if (key.size() != key_size * 2 || !is_valid_key(key)) {
+        return std::nullopt;
+      }
+      auto nibble = [](char chr) {
+        return static_cast<std::uint8_t>(chr <= '9' ? chr - '0' : chr - 'a' + 10);
+      };
+      auto raw = raw_key{};
+      for (std::size_t i = 0; i < key_size; ++i) {
+        raw[i] = static_cast<std::uint8_t>((nibble(key[2 * i]) << 4) | nibble(key[2 * i + 1]));
+      }
+      return raw;
+    }
+
+    auto now() -> std::int64_t {
+      return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+    }
+
+    auto read_all(int fd, void *data, std::size_t size, std::uint64_t offset) -> bool {
+      auto *bytes = static_cast<char *>(data);
+      while (size != 0) {
+        auto ret = ::pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (ret <= 0) {
+          return false;
+        }
+        bytes  += ret;
+        size   -= static_cast<std::size_t>(ret);
+        offset += static_cast<std::uint64_t>(ret);
+      }
+      return true;
+    }
+
+    auto write_all(int fd, const void *data, std::size_t size, std::uint64_t offset) -> bool {
+      const auto *bytes = static_cast<const char *>(data);
+      while (size != 0) {
+        auto ret = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (ret <= 0) {
+          return false;
+        }
+        bytes  += ret;
+        size   -= static_cast<std::size_t>(ret);
+        offset += static_cast<std::uint64_t>(ret);
+      }
+      return true;
+    }
+
+    auto file_size(int fd) -> std::uint64_t {
+      struct stat info{};
+      return ::fstat(fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+    }
+
+    // Open a pack file and lock it. Return -1 on failure.
+    auto open_locked(const fs::path &path) -> int {
+      auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (fd < 0) {
+        return -1;
+      }
+      if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(fd);
+        return -1;
+      }
+      return fd;
+    }
+
+    auto capacity_for(std::uint64_t count) -> std::uint64_t {
+      auto capacity = initial_capacity;
+      while (count * 100 >= capacity * max_load_percent) {
+        capacity *= 2;
+      }
+      return capacity;
+    }
+  } // namespace
+
+  struct pack_backend::index_header {
+    magic_t magic;
+    std::uint64_t capacity;
+    std::uint64_t count;
+    // Bytes of the pack covered by the index. Bytes beyond it are left by an
+    // interrupted write.
+    std::uint64_t pack_size;
+  };
+
+  // An empty slot has a zero offset, which is never valid since the pack
+  // starts with its magic.
+  struct pack_backend::slot {
+    raw_key key;
+    std::uint32_t size;
+    std::uint64_t offset;
+    std::int64_t last_access;
+  };
+
+  pack_backend::pack_backend(std::string dir, std::uint64_t max_size)
+    : dir_(std::move(dir))
+    , max_size_(max_size) {
+    static_assert(sizeof(slot) == 40, "slots are stored in the index file as is");
+    auto ec = std::error_code{};
+    fs::create_directories(dir_, ec);
+    pack_fd_ = open_locked(fs::path{dir_} / pack_name);
+    if (pack_fd_ < 0) {
+      spdlog::warn("result cache {} is unavailable or used by another process, skip it", dir_);
+      return;
+    }
+
+    // A pack of an unknown format is dropped.
+    auto magic = magic_t{};
+    if (!read_all(pack_fd_, magic.data(), magic.size(), 0) || magic != pack_magic) {
+      if (::ftruncate(pack_fd_, 0) != 0 || !write_all(pack_fd_, pack_magic.data(), 8, 0)) {
+        spdlog::warn("failed to initialize result cache {}", dir_);
+        ::close(pack_fd_);
+        pack_fd_ = -1;
+        return;
+      }
+      fs::remove(fs::path{dir_} / index_name, ec);
+    }
+
+    if (!map_index() || header()->pack_size > file_size(pack_fd_)) {
+      unmap_index();
+      if (!rebuild_index()) {
+        spdlog::warn("failed to build the index of result cache {}", dir_);
+        ::close(pack_fd_);
+        pack_fd_ = -1;
+        return;
+      }
+    }
+    pack_size_ = header()->pack_size;
+  }
+
+  pack_backend::~pack_backend() {
+    auto lock = std::lock_guard{mutex_};
+    if (pack_fd_ < 0) {
+      return;
+    }
+    if (max_size_ != 0 && pack_size_ > max_size_) {
+      compact_locked();
+    }
+    unmap_index();
+    ::close(pack_fd_);
+  }
+
+  auto pack_backend::header() const -> index_header * {
+    return static_cast<index_header *>(index_);
+  }
+
+  auto pack_backend::map_index() -> bool {
+    auto fd = ::open((fs::path{dir_} / index_name).c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+    auto bytes = file_size(fd);
+    auto *data = bytes < sizeof(index_header)
+                 ? MAP_FAILED
+                 : ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    index_           = data;
+    index_bytes_     = bytes;
+    const auto *head = header();
+    if (head->magic != index_magic
+        || head->capacity == 0
+        || bytes != sizeof(index_header) + head->capacity * sizeof(slot)) {
+      unmap_index();
+      return false;
+    }
+    return true;
+  }
+
+  void pack_backend::unmap_index() {
+    if (index_ != nullptr) {
+      ::munmap(index_, index_bytes_);
+      index_       = nullptr;
+      index_bytes_ = 0;
+    }
+  }
+
+  auto pack_backend::find_slot(const void *key) const -> slot * {
+    // Keys are hashes already, so their first bytes are used as the hash.
+    auto *slots   = reinterpret_cast<slot *>(header() + 1);
+    auto capacity = header()->capacity;
+    auto hash     = std::uint64_t{0};
+    std::memcpy(&hash, key, sizeof(hash));
+    for (auto i = hash % capacity;; i = (i + 1) % capacity) {
+      if (slots[i].offset == 0 || std::memcmp(slots[i].key.data(), key, key_size) == 0) {
+        return &slots[i];
+      }
+    }
+  }
+
+  auto pack_backend::live_slots() const -> std::vector<slot> {
+    auto ret          = std::vector<slot>{};
+    const auto *head  = header();
+    const auto *slots = reinterpret_cast<const slot *>(head + 1);
+    for (std::uint64_t i = 0; i < head->capacity; ++i) {
+      if (slots[i].offset != 0) {
+        ret.push_back(slots[i]);
+      }
+    }
+    return ret;
+  }
+
+  auto pack_backend::write_index(const std::vector<slot> &slots, std::uint64_t capacity) -> bool {
+    auto path  = fs::path{dir_} / index_name;
+    auto temp  = path;
+    temp      += ".tmp";
+    auto bytes = sizeof(index_header) + capacity * sizeof(slot);
+
+    // Build the new index aside and rename it, so a crash never leaves a
+    // half written index.
+    auto fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      ::close(fd);
+      return false;
+    }
+    auto *data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    unmap_index();
+    index_          = data;
+    index_bytes_    = bytes;
+    auto *head      = header();
+    head->magic     = index_magic;
+    head->capacity  = capacity;
+    head->count     = slots.size();
+    head->pack_size = pack_size_;
+    for (const auto &entry: slots) {
+      *find_slot(entry.key.data()) = entry;
+    }
+
+    auto ec = std::error_code{};
+    fs::rename(temp, path, ec);
+    return !ec;
+  }
+
+  auto pack_backend::rebuild_index() -> bool {
+    spdlog::debug("rebuild the index of result cache {}", dir_);
+    auto offsets = std::unordered_map<std::string, slot>{};
+    auto end     = file_size(pack_fd_);
+    auto offset  = std::uint64_t{pack_magic.size()};
+    auto record  = record_header{};
+    while (offset + record_header_size <= end) {
+      if (!read_all(pack_fd_, &record, record_header_size, offset)
+          || offset + record_header_size + record.size > end) {
+        break;
+      }
+      auto key     = std::string{record.key.begin(), record.key.end()};
+      offsets[key] =
+        slot{.key = record.key, .size = record.size, .offset = offset, .last_access = 0};
+      offset      += record_header_size + record.size;
+    }
+
+    // Drop the torn tail left by an interrupted write.
+    if (offset != end && ::ftruncate(pack_fd_, static_cast<off_t>(offset)) != 0) {
+      return false;
+    }
+    pack_size_ = offset;
+
+    auto slots = std::vector<slot>{};
+    for (auto &[key, entry]: offsets) {
+      entry.last_access = now();
+      slots.push_back(entry);
+    }
+    return write_index(slots, capacity_for(slots.size()));
+  }
+
+  auto pack_backend::get(const std::string &key) -> std::optional<std::string> {
+    auto raw  = to_raw_key(key);
+    auto lock = std::lock_guard{mutex_};
+    if (pack_fd_ < 0 || !raw) {
+      return std::nullopt;
+    }
+    auto *entry = find_slot(raw->data());
+    if (entry->offset == 0) {
+      return std::nullopt;
+    }
+
+    auto value = std::string(entry->size, '\0');
+    if (!read_all(pack_fd_, value.data(), value.size(), entry->offset + record_header_size)) {
+      spdlog::debug("failed to read cache entry {}", key);
+      return std::nullopt;
+    }
+    entry->last_access = now();
+    return value;
+  }
+
+  void pack_backend::put(const std::string &key, const std::string &value) {
+    auto raw  = to_raw_key(key);
+    auto lock = std::lock_guard{mutex_};
+    if (pack_fd_ < 0 || !raw || value.size() > UINT32_MAX) {
+      return;
+    }
+
+    if ((header()->count + 1) * 100 >= header()->capacity * max_load_percent) {
+      if (!write_index(live_slots(), header()->capacity * 2)) {
+        spdlog::warn("failed to grow the index of result cache {}", dir_);
+        return;
+      }
+    }
+
+    // Write the record before indexing it, so the index never points to
+    // missing data.
+    auto record = record_header{.key = *raw, .size = static_cast<std::uint32_t>(value.size())};
+    if (!write_all(pack_fd_, &record, record_header_size, pack_size_)
+        || !write_all(pack_fd_, value.data(), value.size(), pack_size_ + record_header_size)) {
+      spdlog::warn("failed to write cache entry {}", key);
+      return;
+    }
+
+    auto *entry = find_slot(raw->data());
+    if (entry->offset == 0) {
+      ++header()->count;
+    }
+    *entry = slot{.key = *raw, .size = record.size, .offset = pack_size_, .last_access = now()};
+    pack_size_          += record_header_size + value.size();
+    header()->pack_size  = pack_size_;
+  }
+
+  void pack_backend::compact() {
+    auto lock = std::lock_guard{mutex_};
+    if (pack_fd_ >= 0) {
+      compact_locked();
+    }
+  }
+
+  void pack_backend::compact_locked() {
+    auto slots = live_slots();
+    ranges::sort(slots, [](const auto &lhs, const auto &rhs) {
+      return lhs.last_access > rhs.last_access;
+    });
+    auto budget = max_size_ == 0 ? UINT64_MAX : max_size_ * compact_percent / 100;
+
+    auto path = fs::path{dir_} / pack_name;
+    auto temp = path;
+    temp     += ".tmp";
+    auto fd   = open_locked(temp);
+    if (fd < 0 || ::ftruncate(fd, 0) != 0 || !write_all(fd, pack_magic.data(), 8, 0)) {
+      spdlog::warn("failed to compact result cache {}", dir_);
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      return;
+    }
+
+    // Copy the most recently used entries first, until the budget is used up.
+    auto kept   = std::vector<slot>{};
+    auto offset = std::uint64_t{pack_magic.size()};
+    auto buffer = std::string{};
+    for (const auto &entry: slots) {
+      auto record_size = record_header_size + entry.size;
+      if (offset + record_size > budget) {
+        break;
+      }
+      buffer.resize(record_size);
+      if (!read_all(pack_fd_, buffer.data(), record_size, entry.offset)
+          || !write_all(fd, buffer.data(), record_size, offset)) {
+        spdlog::warn("failed to compact result cache {}", dir_);
+        ::close(fd);
+        return;
+      }
+      auto &moved   = kept.emplace_back(entry);
+      moved.offset  = offset;
+      offset       += record_size;
+    }
+
+    auto ec = std::error_code{};
+    fs::rename(temp, path, ec);
+    if (ec) {
+      spdlog::warn("failed to compact result cache {}: {}", dir_, ec.message());
+      ::close(fd);
+      return;
+    }
+    ::close(pack_fd_);
+    pack_fd_   = fd;
+    pack_size_ = offset;
+    if (!write_index(kept, capacity_for(kept.size()))) {
+      // The old index doesn't match the new pack, drop both of them so the
+      // index is rebuilt by the next run.
+      spdlog::warn("failed to write the index of result cache {}", dir_);
+      unmap_index();
+      fs::remove(fs::path{dir_} / index_name, ec);
+      ::close(pack_fd_);
+      pack_fd_ = -1;
+      return;
+    }
+    spdlog::info("compacted result cache {}: kept {} entries in {} bytes, evicted {} entries",
+                 dir_,
+                 kept.size(),
+                 pack_size_,
+                 slots.size() - kept.size());
+  }
+
+  auto pack_backend::size() const -> std::uint64_t {
+    auto lock = std::lock_guard{mutex_};
+    return pack_size_;
+  }
+
+  auto pack_backend::count() const -> std::uint64_t {
+    auto lock = std::lock_guard{mutex_};
+    return index_ == nullptr ? 0 : header()->count;
+  }
+
+  void compact_packs(const std::string &dir, std::uint64_t max_size) {
+    auto ec = std::error_code{};
+    for (const auto &entry: std::filesystem::directory_iterator{dir, ec}) {
+      if (entry.is_directory()) {
+        spdlog::debug("Compact result cache {}", entry.path().string());
+        pack_backend{entry.path().string(), max_size}.compact();
+      }
+    }
+  }
+
+} // namespace lint::cache
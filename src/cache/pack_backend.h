@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cache/backend.h"
+
+namespace lint::cache {
+  /// Entries stored in one append-only pack file with a memory mapped hash
+  /// index beside it, so that saving and restoring the cache directory moves a
+  /// couple of big files instead of many tiny ones.
+  ///
+  /// Replaced entries stay in the pack as garbage until compaction. When the
+  /// pack grows beyond the size cap, it's compacted at close, and least
+  /// recently used entries are evicted. A pack is used by one process at a
+  /// time: other processes skip it while it's locked.
+  class pack_backend : public backend_base {
+  public:
+    /// Open or create the pack in the directory. A `max_size` of 0 means no
+    /// size cap.
+    pack_backend(std::string dir, std::uint64_t max_size);
+    ~pack_backend() override;
+
+    pack_backend(const pack_backend &)            = delete;
+    pack_backend &operator=(const pack_backend &) = delete;
+    pack_backend(pack_backend &&)                 = delete;
+    pack_backend &operator=(pack_backend &&)      = delete;
+
+    auto get(const std::string &key) -> std::optional<std::string> override;
+
+    void put(const std::string &key, const std::string &value) override;
+
+    /// Rewrite the pack with live entries only. Least recently used entries
+    /// are evicted until the pack fits in the size cap, with some headroom.
+    void compact();
+
+    /// Return the size of the pack file in bytes.
+    [[nodiscard]] auto size() const -> std::uint64_t;
+
+    /// Return the number of entries.
+    [[nodiscard]] auto count() const -> std::uint64_t;
+
+  private:
+    struct index_header;
+    struct slot;
+
+    // Map the index file. Return false if it's missing or broken.
+    auto map_index() -> bool;
+    void unmap_index();
+
+    // Write a new index file of the given slots and map it.
+    auto write_index(const std::vector<slot> &slots, std::uint64_t capacity) -> bool;
+
+    // Rebuild the index by scanning the pack, used if the index is lost.
+    auto rebuild_index() -> bool;
+
+    [[nodiscard]] auto live_slots() const -> std::vector<slot>;
+    [[nodiscard]] auto header() const -> index_header *;
+    [[nodiscard]] auto find_slot(const void *key) const -> slot *;
+
+    void compact_locked();
+
+    std::string dir_;
+    std::uint64_t max_size_ = 0;
+    mutable std::mutex mutex_;
+    int pack_fd_             = -1;
+    std::uint64_t pack_size_ = 0;
+    void *index_             = nullptr;
+    std::size_t index_bytes_ = 0;
+  };
+
+  /// Compact the packs in every subdirectory of `dir`, which holds one pack
+  /// per tool. Missing directories are ignored.
+  void compact_packs(const std::string &dir, std::uint64_t max_size);
+
+} // namespace lint::cache
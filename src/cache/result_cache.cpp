@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/result_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include "utils/git_utils.h"
+
+namespace lint::cache {
+  namespace fs = std::filesystem;
+
+  auto key_builder::add(std::string_view part) -> key_builder & {
+    data_ += fmt::format("{}:", part.size());
+    data_ += part;
+    return *this;
+  }
+
+  auto key_builder::add(const git_oid &oid) -> key_builder & {
+    return add(std::string_view{reinterpret_cast<const char *>(oid.id), GIT_OID_SHA1_SIZE});
+  }
+
+  auto key_builder::build() const -> std::string {
+    auto oid = git::odb::hash(data_, GIT_OBJECT_BLOB);
+    auto hex = git::oid::to_str(oid);
+    return {hex.c_str()};
+  }
+
+  namespace {
+    // Read config files from the directory of `file` up to `root_dir`, nearest
+    // first. Only the first found name of each directory is read.
+    auto read_configs(const std::string &root_dir,
+                      const std::string &file,
+                      std::initializer_list<std::string_view> names,
+                      bool nearest_only) -> std::vector<std::string> {
+      auto configs = std::vector<std::string>{};
+      auto root    = fs::path{root_dir}.lexically_normal();
+      auto dir     = (root / file).lexically_normal().parent_path();
+      while (true) {
+        for (auto name: names) {
+          auto config = std::ifstream{dir / name, std::ios::binary};
+          if (config.is_open()) {
+            configs.emplace_back(std::istreambuf_iterator<char>{config},
+                                 std::istreambuf_iterator<char>{});
+            break;
+          }
+        }
+        if (nearest_only && !configs.empty()) {
+          return configs;
+        }
+        if (dir == root || !dir.has_parent_path() || dir == dir.parent_path()) {
+          return configs;
+        }
+        dir = dir.parent_path();
+      }
+    }
+  } // namespace
+
+  auto nearest_config(const std::string &root_dir,
+                      const std::string &file,
+                      std::initializer_list<std::string_view> names) -> std::string {
+    auto configs = read_configs(root_dir, file, names, true);
+    return configs.empty() ? std::string{} : std::move(configs.front());
+  }
+
+  auto config_chain(const std::string &root_dir,
+                    const std::string &file,
+                    std::initializer_list<std::string_view> names) -> std::vector<std::string> {
+    return read_configs(root_dir, file, names, false);
+  }
+
+  result_cache::result_cache(std::string dir) {
+    backends_.push_back(std::make_unique<directory_backend>(std::move(dir)));
+  }
+
+  result_cache::result_cache(std::vector<backend_base_ptr> backends)
+    : backends_(std::move(backends)) {
+  }
+
+  auto result_cache::get(const std::string &key) const -> std::optional<nlohmann::json> {
+    for (std::size_t i = 0; i < backends_.size(); ++i) {
+      auto data = backends_[i]->get(key);
+      if (!data) {
+        continue;
+      }
+      auto value = nlohmann::json::parse(*data, nullptr, false);
+      if (value.is_discarded()) {
+        spdlog::debug("ignore broken cache entry {}", key);
+        continue;
+      }
+      for (std::size_t j = 0; j < i; ++j) {
+        backends_[j]->put(key, *data);
+      }
+      return value;
+    }
+    return std::nullopt;
+  }
+
+  void result_cache::put(const std::string &key, const nlohmann::json &value) const {
+    auto data = value.dump();
+    for (const auto &backend: backends_) {
+      backend->put(key, data);
+    }
+  }
+
+} // namespace lint::cache
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <git2/oid.h>
+#include <nlohmann/json.hpp>
+
+#include "cache/backend.h"
+
+namespace lint::cache {
+  /// Build a cache key from all parts which affect a result. Each part is
+  /// length prefixed, so different splits of the same bytes never collide.
+  class key_builder {
+  public:
+    auto add(std::string_view part) -> key_builder &;
+    auto add(const git_oid &oid) -> key_builder &;
+
+    /// Return the hex SHA-1 of all added parts.
+    [[nodiscard]] auto build() const -> std::string;
+
+  private:
+    std::string data_;
+  };
+
+  /// Read the nearest config file with one of the given names, searching
+  /// from the directory of `file` up to `root_dir`. Return an empty string if
+  /// no config file is found.
+  auto nearest_config(const std::string &root_dir,
+                      const std::string &file,
+                      std::initializer_list<std::string_view> names) -> std::string;
+
+  /// Read all config files with one of the given names, from the directory
+  /// of `file` up to `root_dir`, nearest first. It's used by tools whose
+  /// configs may inherit from parent directories.
+  auto config_chain(const std::string &root_dir,
+                    const std::string &file,
+                    std::initializer_list<std::string_view> names) -> std::vector<std::string>;
+
+  /// A persistent cache of per-file results, keyed by key_builder. Values are
+  /// json documents kept by one or more backends, which are searched in
+  /// order. It's thread safe.
+  class result_cache {
+  public:
+    /// Keep results in the local directory only.
+    explicit result_cache(std::string dir);
+
+    explicit result_cache(std::vector<backend_base_ptr> backends);
+
+    /// Return the cached value of the key, or std::nullopt on miss. A value
+    /// found by a later backend is copied into the earlier ones, so a remote
+    /// hit is served locally next time.
+    [[nodiscard]] auto get(const std::string &key) const -> std::optional<nlohmann::json>;
+
+    /// Store the value of the key into all backends.
+    void put(const std::string &key, const nlohmann::json &value) const;
+
+  private:
+    std::vector<backend_base_ptr> backends_;
+  };
+
+} // namespace lint::cache
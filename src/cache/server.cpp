@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/server.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace lint::cache {
+  namespace {
+    // Results are small json documents, larger entries are rejected.
+    constexpr auto max_entry_size = std::size_t{64} * 1024 * 1024;
+
+    constexpr auto key_pattern = R"(.*/([0-9a-f]+))";
+  } // namespace
+
+  cache_server::cache_server(std::string dir, std::string token, std::uint64_t max_size)
+    : storage_(std::move(dir), max_size)
+    , max_size_(max_size)
+    , token_(std::move(token)) {
+    server_.set_payload_max_length(max_entry_size);
+
+    server_.Get(key_pattern, [this](const httplib::Request &request, httplib::Response &response) {
+      auto key = request.matches[1].str();
+      if (!is_authorized(request)) {
+        response.status = httplib::StatusCode::Unauthorized_401;
+        return;
+      }
+      if (!is_valid_key(key)) {
+        response.status = httplib::StatusCode::BadRequest_400;
+        return;
+      }
+      auto value = storage_.get(key);
+      if (!value) {
+        response.status = httplib::StatusCode::NotFound_404;
+        return;
+      }
+      response.set_content(std::move(*value), "application/json");
+    });
+
+    server_.Put(key_pattern, [this](const httplib::Request &request, httplib::Response &response) {
+      auto key = request.matches[1].str();
+      if (!is_authorized(request)) {
+        response.status = httplib::StatusCode::Unauthorized_401;
+        return;
+      }
+      if (!is_valid_key(key)) {
+        response.status = httplib::StatusCode::BadRequest_400;
+        return;
+      }
+      storage_.put(key, request.body);
+      if (max_size_ != 0 && storage_.size() > max_size_) {
+        storage_.compact();
+      }
+      response.status = httplib::StatusCode::NoContent_204;
+    });
+
+    server_.set_logger([](const httplib::Request &request, const httplib::Response &response) {
+      spdlog::debug("{} {} {}", request.method, request.path, response.status);
+    });
+  }
+
+  auto cache_server::is_authorized(const httplib::Request &request) const -> bool {
+    return token_.empty()
+        || request.get_header_value("Authorization") == fmt::format("Bearer {}", token_);
+  }
+
+  auto cache_server::bind(const std::string &host, int port) -> int {
+    if (token_.empty() && !is_loopback(host)) {
+      spdlog::error("refuse to listen on {} without a token", host);
+      return -1;
+    }
+    if (port == 0) {
+      return server_.bind_to_any_port(host);
+    }
+    return server_.bind_to_port(host, port) ? port : -1;
+  }
+
+  auto cache_server::serve() -> bool {
+    return server_.listen_after_bind();
+  }
+
+  auto cache_server::is_running() const -> bool {
+    return server_.is_running();
+  }
+
+  void cache_server::stop() {
+    server_.stop();
+  }
+
+  auto is_loopback(const std::string &host) -> bool {
+    return host == "localhost" || host == "::1" || host.starts_with("127.");
+  }
+
+} // namespace lint::cache
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <httplib.h>
+
+#include "cache/pack_backend.h"
+
+namespace lint::cache {
+  /// A minimal server of the remote result cache, which keeps entries in a
+  /// pack under a local directory. It serves `GET <prefix>/<key>` and
+  /// `PUT <prefix>/<key>` for any prefix, so it can be mounted behind a
+  /// reverse proxy.
+  class cache_server {
+  public:
+    /// If the token isn't empty, requests must carry it as a bearer token.
+    /// Least recently used entries are evicted beyond `max_size` bytes, and 0
+    /// means no size cap.
+    cache_server(std::string dir, std::string token, std::uint64_t max_size);
+
+    /// Bind to the host and port. If the port is 0, any free port is used.
+    /// Without a token, anyone who reaches the server could store results, so
+    /// only loopback addresses are allowed then. Return the bound port, or -1
+    /// on failure.
+    auto bind(const std::string &host, int port) -> int;
+
+    /// Serve requests until stop() is called.
+    auto serve() -> bool;
+
+    /// Whether serve() is accepting requests.
+    [[nodiscard]] auto is_running() const -> bool;
+
+    void stop();
+
+  private:
+    [[nodiscard]] auto is_authorized(const httplib::Request &request) const -> bool;
+
+    pack_backend storage_;
+    std::uint64_t max_size_;
+    std::string token_;
+    httplib::Server server_;
+  };
+
+  /// Whether the host is a loopback address, which is only reachable from
+  /// the same machine.
+  auto is_loopback(const std::string &host) -> bool;
+
+} // namespace lint::cache
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+#include <spdlog/spdlog.h>
+
+#include "cache/server.h"
+#include "utils/common.h"
+
+namespace po = boost::program_options;
+
+namespace {
+  // The token is read from the environment, so it doesn't leak into the
+  // process list.
+  constexpr auto token_env = "CPP_LINT_ACTION_CACHE_TOKEN";
+
+  auto create_desc() -> po::options_description {
+    const auto *dir   = po::value<std::string>()->value_name("dir")->required();
+    const auto *host  = po::value<std::string>()->value_name("host")->default_value("127.0.0.1");
+    const auto *port  = po::value<int>()->value_name("port")->default_value(8080);
+    const auto *size  = po::value<std::uint64_t>()->value_name("MiB")->default_value(1024);
+    const auto *level = po::value<std::string>()->value_name("level")->default_value("info");
+
+    auto desc = po::options_description{"cpp-lint-action-cache-server options"};
+    // clang-format off
+    desc.add_options()
+      ("help",                "Display help message")
+      ("dir",        dir,     "Set the directory where cache entries are stored")
+      ("host",       host,    "Set the address to listen on. Addresses other than loopback "
+                              "ones require the token in $CPP_LINT_ACTION_CACHE_TOKEN")
+      ("port",       port,    "Set the port to listen on. 0 means any free port")
+      ("max-size",   size,    "Set the size cap of stored entries in MiB. Least recently "
+                              "used entries are evicted beyond it. 0 means no cap")
+      ("log-level",  level,   "Set the log verbose level. Supports: [trace, debug, info, error]")
+    ;
+    // clang-format on
+    return desc;
+  }
+} // namespace
+
+/// A result cache server shared by cpp-lint-action runs, such as runs of
+/// the same pull request on different runners. Pass its url to
+/// cpp-lint-action by --result-cache-url.
+auto main(int argc, char **argv) -> int {
+  auto desc      = create_desc();
+  auto variables = po::variables_map{};
+  po::store(po::parse_command_line(argc, argv, desc), variables);
+  if (variables.contains("help")) {
+    std::cout << desc << "\n";
+    return 0;
+  }
+  po::notify(variables);
+  lint::set_log_level(variables["log-level"].as<std::string>());
+
+  constexpr auto mebibyte = std::uint64_t{1024} * 1024;
+
+  const auto *token = std::getenv(token_env);
+  auto server       = lint::cache::cache_server{variables["dir"].as<std::string>(),
+                                          token == nullptr ? std::string{} : std::string{token},
+                                          variables["max-size"].as<std::uint64_t>() * mebibyte};
+  auto host         = variables["host"].as<std::string>();
+  auto port         = server.bind(host, variables["port"].as<int>());
+  if (port < 0) {
+    spdlog::error("failed to listen on {}:{}", host, variables["port"].as<int>());
+    return 1;
+  }
+  spdlog::info("cache server listens on {}:{}", host, port);
+  return server.serve() ? 0 : 1;
+}
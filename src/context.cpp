@@ -15,10 +15,128 @@
  */
 #include "context.h"
 
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
 #include <magic_enum/magic_enum.hpp>
+#include <unistd.h>
 #include <spdlog/spdlog.h>
 
+#include "utils/error.h"
+#include "utils/includes.h"
+
 namespace lint {
+  patch_cache::patch_cache(git::diff_ptr diff)
+    : diff_(std::move(diff)) {
+    auto num_deltas = git::diff::num_deltas(*diff_);
+    for (std::size_t i = 0; i < num_deltas; ++i) {
+      const auto *delta = git::diff::get_delta(*diff_, i);
+      throw_if(delta == nullptr, "get delta failed since null pointer");
+      indexes_[delta->new_file.path] = i;
+    }
+  }
+
+  auto patch_cache::get(const std::string &file) const -> git_patch & {
+    auto lock = std::lock_guard{*mutex_};
+    if (auto iter = patches_.find(file); iter != patches_.end()) {
+      return *iter->second;
+    }
+    auto iter = indexes_.find(file);
+    throw_if(iter == indexes_.end(), fmt::format("{} isn't a changed file", file));
+    auto patch = git::patch::create_from_diff(*diff_, iter->second);
+    return *patches_.emplace(file, std::move(patch)).first->second;
+  }
+
+  auto patch_cache::contains(const std::string &file) const -> bool {
+    return indexes_.contains(file);
+  }
+
+  auto patch_cache::empty() const -> bool {
+    return indexes_.empty();
+  }
+
+  tree_entry_cache::tree_entry_cache(git_repository &repo, git::tree_ptr tree)
+    : repo_(&repo)
+    , tree_(std::move(tree)) {
+  }
+
+  auto tree_entry_cache::lookup(const std::string &file) const -> std::optional<git_oid> {
+    throw_if(tree_ == nullptr, "tree entry cache has no tree");
+    auto lock = std::lock_guard{*mutex_};
+    if (auto iter = entries_.find(file); iter != entries_.end()) {
+      return iter->second;
+    }
+    auto entry_id = git::tree::blob_id_bypath(*tree_, file);
+    entries_.emplace(file, entry_id);
+    return entry_id;
+  }
+
+  auto tree_entry_cache::read(const std::string &file) const -> std::optional<git::blob_view> {
+    auto entry_id = lookup(file);
+    if (!entry_id) {
+      return std::nullopt;
+    }
+    return git::blob::view(*repo_, *entry_id);
+  }
+
+  source_snapshot::source_snapshot(std::string file, std::string path, const git_diff_delta &delta)
+    : file_(std::move(file))
+    , path_(std::move(path))
+    , id_(delta.new_file.id)
+    , status_(delta.status) {
+  }
+
+  auto source_snapshot::file() const -> const std::string & {
+    return file_;
+  }
+
+  auto source_snapshot::id() const -> const git_oid & {
+    return id_;
+  }
+
+  auto source_snapshot::status() const -> git_delta_t {
+    return status_;
+  }
+
+  void source_snapshot::load() const {
+    std::call_once(loaded_, [this] {
+      if (status_ != GIT_DELTA_DELETED) {
+        mapped_.emplace(path_);
+      }
+      lines_.emplace(mapped_ ? mapped_->content() : std::string_view{});
+    });
+  }
+
+  auto source_snapshot::content() const -> std::string_view {
+    load();
+    return mapped_ ? mapped_->content() : std::string_view{};
+  }
+
+  auto source_snapshot::lines() const -> const line_index & {
+    load();
+    return *lines_;
+  }
+
+  auto source_snapshot::hunks(const patch_cache &patches) const -> const git::hunk_index & {
+    std::call_once(hunks_built_, [&] { hunks_.emplace(patches.get(file_)); });
+    return *hunks_;
+  }
+
+  auto snapshot_cache::get(const std::string &dir,
+                           const std::unordered_map<std::string, git_diff_delta> &deltas,
+                           const std::string &file) const -> const source_snapshot & {
+    auto lock = std::lock_guard{*mutex_};
+    if (auto iter = snapshots_.find(file); iter != snapshots_.end()) {
+      return *iter->second;
+    }
+    auto delta = deltas.find(file);
+    throw_if(delta == deltas.end(), fmt::format("{} isn't a changed file", file));
+    auto snapshot =
+      std::make_unique<source_snapshot>(file, fmt::format("{}/{}", dir, file), delta->second);
+    return *snapshots_.emplace(file, std::move(snapshot)).first->second;
+  }
 
   void fill_git_info(runtime_context &context) {
     spdlog::trace("Enter fill_git_info()");
@@ -28,6 +146,7 @@ namespace lint {
     assert(context.patches.empty() && "given context already has patches");
     assert(context.deltas.empty() && "given context already has deltas");
     assert(context.changed_files.empty() && "given context already has changed files");
+    assert(context.renames.empty() && "given context already has renames");
 
     assert(!context.repo_path.empty() && "repo_path of context is empty()");
     assert(!context.target.empty() && "target of context is empty()");
@@ -36,10 +155,152 @@ namespace lint {
     context.repo          = git::repo::open(context.repo_path);
     context.target_commit = git::revparse::commit(*context.repo, context.target);
     context.source_commit = git::revparse::commit(*context.repo, context.source);
-    auto diff       = git::diff::get(*context.repo, *context.target_commit, *context.source_commit);
-    context.patches = git::patch::create_from_diff(*diff);
-    context.deltas  = git::diff::deltas(*diff);
-    context.changed_files = git::patch::changed_files(context.patches);
+
+    auto &repo   = *context.repo;
+    auto &target = *context.target_commit;
+    auto &source = *context.source_commit;
+
+    // Paths out of the pathspec are never loaded or compared by libgit2.
+    auto opts     = git::diff::init_option();
+    auto pathspec = std::vector<char *>{};
+    for (const auto &spec: context.pathspec) {
+      pathspec.push_back(const_cast<char *>(spec.c_str())); // NOLINT
+    }
+    opts.pathspec.strings = pathspec.data();
+    opts.pathspec.count   = pathspec.size();
+    auto diff             = git::diff::commit_to_commit(repo, target, source, opts);
+
+    // Renamed files are paired, so results of their old paths can be reused.
+    if (context.rename_threshold != 0) {
+      auto find_opts             = git::diff::init_find_option();
+      find_opts.flags            = GIT_DIFF_FIND_RENAMES;
+      find_opts.rename_threshold = context.rename_threshold;
+      find_opts.rename_limit     = context.rename_limit;
+      git::diff::find_similar(*diff, find_opts);
+    }
+    context.deltas = git::diff::deltas(*diff);
+    for (std::size_t i = 0; i < git::diff::num_deltas(*diff); ++i) {
+      context.changed_files.emplace_back(git::diff::get_delta(*diff, i)->new_file.path);
+    }
+    for (const auto &[file, delta]: context.deltas) {
+      if (delta.status == GIT_DELTA_RENAMED) {
+        context.renames[file] = delta.old_file.path;
+      }
+    }
+    context.patches     = patch_cache{std::move(diff)};
+    context.source_tree = tree_entry_cache{repo, git::commit::tree(source)};
+  }
+
+  namespace {
+    // Configs of tools, which are searched from the directory of a file up to
+    // the repository root.
+    constexpr auto tool_configs = {".clang-format", "_clang-format", ".clang-tidy"};
+
+    // Return the path of an included file relative to the repository root.
+    // Like a compiler, quoted includes are searched from the directory of the
+    // including file first, then all includes are searched from the include
+    // directories. Quoted includes are searched from the root at last.
+    auto resolve_include(const tree_entry_cache &tree,
+                         const std::string &file,
+                         const include_directive &include,
+                         const std::vector<std::string> &include_dirs)
+      -> std::optional<std::string> {
+      auto candidates = std::vector<std::filesystem::path>{};
+      if (include.quoted) {
+        candidates.push_back(std::filesystem::path{file}.parent_path() / include.path);
+      }
+      for (const auto &dir: include_dirs) {
+        candidates.push_back(std::filesystem::path{dir} / include.path);
+      }
+      if (include.quoted) {
+        candidates.emplace_back(include.path);
+      }
+      for (const auto &candidate: candidates) {
+        auto path = candidate.lexically_normal().generic_string();
+        if (path.empty() || path == "." || path.starts_with("..") || path.starts_with('/')) {
+          continue;
+        }
+        if (tree.lookup(path)) {
+          return path;
+        }
+      }
+      return std::nullopt;
+    }
+
+    void write_file(const std::filesystem::path &path, std::string_view content) {
+      std::filesystem::create_directories(path.parent_path());
+      auto file = std::ofstream{path, std::ios::binary};
+      throw_unless(file.is_open(), fmt::format("failed to write {}", path.string()));
+      file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+  } // namespace
+
+  auto write_revision_files(const runtime_context &context,
+                            const std::vector<std::string> &files,
+                            const std::vector<std::string> &include_dirs) -> std::size_t {
+    spdlog::trace("Enter write_revision_files()");
+    assert(!context.checkout_dir.empty() && "checkout_dir of context is empty()");
+    auto dir = std::filesystem::path{context.checkout_dir};
+
+    // Included files are written as well, since tools like clang-tidy need
+    // them to parse a changed file.
+    auto written = std::unordered_set<std::string>{};
+    auto pending = std::deque<std::string>{files.begin(), files.end()};
+    while (!pending.empty()) {
+      auto file = std::move(pending.front());
+      pending.pop_front();
+      if (written.contains(file)) {
+        continue;
+      }
+      auto view = context.source_tree.read(file);
+      if (!view) {
+        continue;
+      }
+      write_file(dir / file, view->content());
+      written.insert(file);
+      for (const auto &include: find_includes(view->content())) {
+        if (auto path = resolve_include(context.source_tree, file, include, include_dirs)) {
+          pending.push_back(std::move(*path));
+        } else {
+          // Such as system headers and headers generated into the build
+          // directory, which are found out of the checkout directory.
+          spdlog::debug("{} included by {} isn't in the source revision", include.path, file);
+        }
+      }
+    }
+
+    auto dirs = std::unordered_set<std::string>{};
+    for (const auto &file: written) {
+      auto parent = std::filesystem::path{file}.parent_path();
+      while (dirs.insert(parent.generic_string()).second) {
+        for (const auto *name: tool_configs) {
+          auto config = (parent / name).generic_string();
+          if (auto view = context.source_tree.read(config)) {
+            write_file(dir / config, view->content());
+          }
+        }
+        if (parent.empty()) {
+          break;
+        }
+        parent = parent.parent_path();
+      }
+    }
+    return written.size();
+  }
+
+  void write_source_files(runtime_context &context) {
+    spdlog::trace("Enter write_source_files()");
+    assert(context.checkout_dir.empty() && "given context already has a checkout directory");
+    assert(!context.scratch_dir.empty() && "scratch_dir of context is empty()");
+
+    auto dir = std::filesystem::path{context.scratch_dir}
+             / fmt::format("cpp-lint-action-{}", ::getpid());
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    context.checkout_dir = dir.string();
+
+    auto num_written = write_revision_files(context, context.changed_files, {});
+    spdlog::info("Wrote {} files of the source revision into {}", num_written, dir.string());
   }
 
   void print_context(const runtime_context &ctx) {
@@ -50,6 +311,19 @@ namespace lint {
     spdlog::debug("enable pull request review: {}", ctx.enable_pull_request_review);
     spdlog::debug("enable action output: {}", ctx.enable_action_output);
     spdlog::debug("disable errors: {}", ctx.disable_errors);
+    spdlog::debug("jobs: {}", ctx.jobs);
+    spdlog::debug("cache dir: {}", ctx.cache_dir);
+    spdlog::debug("enable result cache: {}", ctx.enable_result_cache);
+    spdlog::debug("result cache max size: {}", ctx.result_cache_max_size);
+    spdlog::debug("result cache url: {}", ctx.result_cache_url);
+    spdlog::debug("result cache token: {}", ctx.result_cache_token.empty() ? "" : "***");
+    spdlog::debug("rename threshold: {}", ctx.rename_threshold);
+    spdlog::debug("rename limit: {}", ctx.rename_limit);
+    spdlog::debug("include paths: {}", concat(ctx.include_paths, ','));
+    spdlog::debug("exclude paths: {}", concat(ctx.exclude_paths, ','));
+    spdlog::debug("diff pathspec: {}", concat(ctx.pathspec, ' '));
+    spdlog::debug("lint from odb: {}", ctx.lint_from_odb);
+    spdlog::debug("scratch dir: {}", ctx.scratch_dir);
     spdlog::debug("repository path: {}", ctx.repo_path);
     spdlog::debug("repository: {}", ctx.repo_pair);
     spdlog::debug("repository token: {}", ctx.token.empty() ? "" : "***");
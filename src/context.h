@@ -17,12 +17,114 @@
 
 #include <cstdint>
 #include <git2/repository.h>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "utils/git_utils.h"
+#include "utils/line_index.h"
 
 namespace lint {
+  /// Patches of changed files, built from the diff on first use. Building a
+  /// patch loads and compares both blobs, so it's only paid for files whose
+  /// hunks are needed, such as files commented on. It's thread safe.
+  class patch_cache {
+  public:
+    patch_cache() = default;
+    explicit patch_cache(git::diff_ptr diff);
+
+    /// Return the patch of a changed file.
+    auto get(const std::string &file) const -> git_patch &;
+
+    [[nodiscard]] auto contains(const std::string &file) const -> bool;
+
+    [[nodiscard]] auto empty() const -> bool;
+
+  private:
+    git::diff_ptr diff_{nullptr, ::git_diff_free};
+    std::unordered_map<std::string, std::size_t> indexes_;
+    std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
+    mutable std::unordered_map<std::string, git::patch_ptr> patches_;
+  };
+
+  /// Blob ids of files in a tree, resolved from their paths on first use, so
+  /// tools and reporters reading a file of the tree only walk the tree once
+  /// per path. It's thread safe.
+  class tree_entry_cache {
+  public:
+    tree_entry_cache() = default;
+    tree_entry_cache(git_repository &repo, git::tree_ptr tree);
+
+    /// Return the blob id of a file, or nullopt if the tree hasn't the file.
+    auto lookup(const std::string &file) const -> std::optional<git_oid>;
+
+    /// Return the content of a file without copying it, or nullopt if the
+    /// tree hasn't the file.
+    auto read(const std::string &file) const -> std::optional<git::blob_view>;
+
+  private:
+    git_repository *repo_ = nullptr;
+    git::tree_ptr tree_{nullptr, ::git_tree_free};
+    std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
+    mutable std::unordered_map<std::string, std::optional<git_oid>> entries_;
+  };
+
+  /// A changed file of the source revision shared by all tools and reporters,
+  /// so each of them doesn't read the file again. The content is mapped and
+  /// its lines are indexed on first use, and the hunk index is built from the
+  /// patch of the file on first use. It's thread safe.
+  class source_snapshot {
+  public:
+    source_snapshot(std::string file, std::string path, const git_diff_delta &delta);
+
+    /// The path relative to the repository root.
+    [[nodiscard]] auto file() const -> const std::string &;
+
+    [[nodiscard]] auto id() const -> const git_oid &;
+
+    [[nodiscard]] auto status() const -> git_delta_t;
+
+    /// Return the content of the file, which is empty for a deleted file.
+    auto content() const -> std::string_view;
+
+    auto lines() const -> const line_index &;
+
+    /// Return the hunk index of the file. `patches` must be the ones the
+    /// snapshot is made from.
+    auto hunks(const patch_cache &patches) const -> const git::hunk_index &;
+
+  private:
+    void load() const;
+
+    std::string file_;
+    std::string path_;
+    git_oid id_{};
+    git_delta_t status_ = GIT_DELTA_UNMODIFIED;
+
+    mutable std::once_flag loaded_;
+    mutable std::optional<mapped_file> mapped_;
+    mutable std::optional<line_index> lines_;
+    mutable std::once_flag hunks_built_;
+    mutable std::optional<git::hunk_index> hunks_;
+  };
+
+  /// Snapshots of changed files, made on first use. It's thread safe.
+  class snapshot_cache {
+  public:
+    /// Return the snapshot of a changed file, which is read from `dir`.
+    auto get(const std::string &dir,
+             const std::unordered_map<std::string, git_diff_delta> &deltas,
+             const std::string &file) const -> const source_snapshot &;
+
+  private:
+    std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
+    mutable std::unordered_map<std::string, std::unique_ptr<source_snapshot>> snapshots_;
+  };
+
   /// The runtime context for all tools.
   struct runtime_context {
     // Theses will be filled by [ program_options::fill_context() ]
@@ -31,6 +133,26 @@ namespace lint {
     bool enable_pull_request_review = false;
     bool enable_action_output       = false;
     bool disable_errors             = false;
+    std::size_t jobs                = 1;
+    std::string cache_dir;
+    bool enable_result_cache            = true;
+    std::uint64_t result_cache_max_size = 0;
+    std::string result_cache_url;
+    std::string result_cache_token;
+    // The minimum similarity in percent of a renamed file. 0 disables rename
+    // detection, so a renamed file is a deleted file plus an added file. It's
+    // opt-in, since only modified lines of a detected rename are changed
+    // lines, rather than all lines of an added file.
+    std::uint16_t rename_threshold = 0;
+    std::size_t rename_limit       = 1000;
+    // Globs of paths to be diffed. Paths matched by exclude_paths are never
+    // diffed even if they're included.
+    std::vector<std::string> include_paths;
+    std::vector<std::string> exclude_paths;
+    // Read files to check from the object database instead of the working
+    // tree, which may be on another revision or not checked out at all.
+    bool lint_from_odb = false;
+    std::string scratch_dir;
 
     // Theses will be filled by [ github::fill_context() ]
     std::string repo_path;
@@ -41,18 +163,61 @@ namespace lint {
     std::string source;
     std::int32_t pr_number = -1;
 
+    // The pathspec of the diff, made from the paths above and file filters
+    // of enabled tools. An empty pathspec diffs all paths.
+    std::vector<std::string> pathspec;
+
     // Theses will be filled by [ fill_git_info ]
     git::repo_ptr repo{nullptr, ::git_repository_free};
     git::commit_ptr target_commit{nullptr, ::git_commit_free};
     git::commit_ptr source_commit{nullptr, ::git_commit_free};
 
-    // The diff patches of source revision to target revision.
-    std::unordered_map<std::string, git::patch_ptr> patches;
+    // The diff patches of source revision to target revision. It owns the
+    // diff, which paths of deltas point into.
+    patch_cache patches;
     std::unordered_map<std::string, git_diff_delta> deltas;
     std::vector<std::string> changed_files;
+    // Old paths of renamed files keyed by their new paths.
+    std::unordered_map<std::string, std::string> renames;
+    // Files of the source revision, read from the object database.
+    tree_entry_cache source_tree;
+
+    // Theses will be filled by [ write_source_files ]
+    std::string checkout_dir;
+
+    // Snapshots of changed files, read from work_dir().
+    snapshot_cache snapshots;
+
+    /// The directory where tools find files of the source revision.
+    [[nodiscard]] auto work_dir() const -> const std::string & {
+      return checkout_dir.empty() ? repo_path : checkout_dir;
+    }
+
+    /// Return the snapshot of a changed file. Files are read after
+    /// write_source_files, so the snapshot of a file is the one tools see.
+    auto snapshot(const std::string &file) const -> const source_snapshot & {
+      return snapshots.get(work_dir(), deltas, file);
+    }
   };
 
   void fill_git_info(runtime_context &context);
 
+  /// Write changed files of the source revision into a new directory under
+  /// scratch_dir, together with the files they include by quotes and the
+  /// tool configs of their directories. Tools then run there, so a working
+  /// tree isn't needed.
+  void write_source_files(runtime_context &context);
+
+  /// Write files of the source revision into checkout_dir, together with the
+  /// files they include, transitively, and the tool configs of their
+  /// directories. Includes are searched from `include_dirs`, which are
+  /// relative to the repository root, like a compiler does. Includes which
+  /// aren't in the source revision are skipped, so files generated into the
+  /// build directory and system headers are still found out of checkout_dir.
+  /// Return the number of written files.
+  auto write_revision_files(const runtime_context &context,
+                            const std::vector<std::string> &files,
+                            const std::vector<std::string> &include_dirs) -> std::size_t;
+
   void print_context(const runtime_context &ctx);
 } // namespace lint
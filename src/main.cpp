@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 #include <cctype>
+#include <exception>
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,8 +23,10 @@
 #include <git2/oid.h>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <range/v3/algorithm/count_if.hpp>
 #include <spdlog/spdlog.h>
 
+#include "cache/pack_backend.h"
 #include "configs/version.h"
 #include "context.h"
 #include "github/common.h"
@@ -76,15 +80,18 @@ namespace {
                              git::commit::id_str(*ctx.source_commit)));
   }
 
-  void print_tools_info(const std::vector<tool::tool_base_ptr> &tools) {
-    if (tools.empty()) {
+  void print_tools_info(const std::vector<tool::tool_slot> &slots) {
+    if (slots.empty()) {
       spdlog::error("Zero tools are enabled. Does this's an expected behavior?");
       return;
     }
-    spdlog::info("Enabled {} tools:", tools.size());
+    auto num_tools = ranges::count_if(slots, [](const auto &slot) { return slot.tool != nullptr; });
+    spdlog::info("Enabled {} tools:", num_tools);
     constexpr auto line = "{}:\texecutable binary path: {}\tversion:{}";
-    for (const auto &tool: tools) {
-      spdlog::info(line, tool->name(), tool->binary(), tool->version());
+    for (const auto &slot: slots) {
+      if (slot.tool) {
+        spdlog::info(line, slot.tool->name(), slot.tool->binary(), slot.tool->version());
+      }
     }
   }
 
@@ -102,13 +109,41 @@ namespace {
         passed,
         failed,
         ignored);
+      if (auto [hits, misses] = reporter->get_cache_stats(); hits + misses != 0) {
+        spdlog::info("{} result cache:\thits: {}\tmisses: {}", tool, hits, misses);
+      }
     }
   }
 
+  // Compact the local result caches of all tools, such as before saving the
+  // cache directory by actions/cache. Usage: cpp-lint-action cache compact
+  // [--cache-dir=dir] [--result-cache-max-size=MiB]
+  auto compact_result_caches(int argc, char **argv) -> int {
+    auto desc    = program_options::create_desc();
+    auto options = program_options::parse(argc, argv, desc);
+    if (options.contains("help")) {
+      std::cout << desc << "\n";
+      return 0;
+    }
+    set_log(options);
+
+    auto context = runtime_context{};
+    program_options::fill_cache_context(options, context);
+    cache::compact_packs(fmt::format("{}/results", context.cache_dir),
+                         context.result_cache_max_size);
+    return 0;
+  }
 
 } // namespace
 
-auto main(int argc, char **argv) -> int {
+// Exceptions are caught by main, so the stack is unwound and scope guards
+// always run.
+auto main(int argc, char **argv) -> int try {
+  // Subcommands have their own options, so they're dispatched first.
+  if (argc >= 3 && argv[1] == "cache"sv && argv[2] == "compact"sv) {
+    return compact_result_caches(argc - 2, argv + 2);
+  }
+
   auto tool_creators = collect_tool_creators();
 
   // Handle program options.
@@ -125,9 +160,6 @@ auto main(int argc, char **argv) -> int {
   }
   set_log(user_options);
 
-  auto tools = tool::create_enabled_tools(tool_creators, user_options);
-  print_tools_info(tools);
-
   // Create runtime context.
   auto context = runtime_context{};
 
@@ -138,15 +170,31 @@ auto main(int argc, char **argv) -> int {
   auto env = github::read_env();
   github::fill_context(env, context);
 
-  // Fill runtime context by git repositofy informations.
+  // Fill runtime context by git repositofy informations. It's done before
+  // tools are created, so tools without any file to check are skipped.
   git::setup();
+  context.pathspec = tool::make_diff_pathspec(tool_creators, user_options, context);
   fill_git_info(context);
 
   print_context(context);
-  check_repo_is_on_source(context);
+  // The checkout directory may be in memory, so it's removed on all paths.
+  auto remove_checkout = scope_guard{[&context] {
+    if (!context.checkout_dir.empty()) {
+      auto ec = std::error_code{};
+      std::filesystem::remove_all(context.checkout_dir, ec);
+    }
+  }};
+  if (context.lint_from_odb) {
+    write_source_files(context);
+  } else {
+    check_repo_is_on_source(context);
+  }
+
+  auto slots = tool::create_enabled_tools(tool_creators, user_options, context);
+  print_tools_info(slots);
 
-  // Run tools within the given context and get reporters.
-  auto reporters = tool::run_tools(tools, context);
+  // Run tools within the given context and get reporters in creator order.
+  auto reporters = tool::run_tools(slots, context);
   print_brief_result(reporters, context.changed_files.size());
 
   if (context.enable_action_output) {
@@ -168,5 +216,8 @@ auto main(int argc, char **argv) -> int {
     return 0;
   }
   return all_passed(reporters) ? 0 : 1;
+} catch (const std::exception &err) {
+  spdlog::error("{}", err.what());
+  return 1;
 }
 
@@ -15,6 +15,9 @@
  */
 #include "program_options.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
 #include <initializer_list>
 
 #include <boost/algorithm/string/case_conv.hpp>
@@ -22,7 +25,9 @@
 #include <spdlog/spdlog.h>
 
 #include "context.h"
+#include "utils/common.h"
 #include "utils/error.h"
+#include "utils/thread_pool.h"
 
 namespace lint::program_options {
   namespace {
@@ -35,6 +40,52 @@ namespace lint::program_options {
     constexpr auto enable_pull_request_review = "enable-pull-request-review";
     constexpr auto enable_action_output       = "enable-action-output";
     constexpr auto disable_errors             = "disable-errors";
+    constexpr auto jobs                       = "jobs";
+    constexpr auto cache_dir                  = "cache-dir";
+    constexpr auto enable_result_cache        = "enable-result-cache";
+    constexpr auto result_cache_url           = "result-cache-url";
+    constexpr auto result_cache_max_size      = "result-cache-max-size";
+    constexpr auto rename_threshold           = "rename-threshold";
+    constexpr auto rename_limit               = "rename-limit";
+    constexpr auto include_paths              = "include-paths";
+    constexpr auto exclude_paths              = "exclude-paths";
+    constexpr auto lint_from_odb              = "lint-from-odb";
+    constexpr auto scratch_dir                = "scratch-dir";
+
+    // The token of the remote result cache is read from the environment, so it
+    // doesn't leak into logs of the command line.
+    constexpr auto result_cache_token_env = "CPP_LINT_ACTION_CACHE_TOKEN";
+
+    // Follow the XDG base directory specification.
+    auto default_cache_dir() -> std::string {
+      if (const auto *xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') {
+        return fmt::format("{}/cpp-lint-action", xdg);
+      }
+      if (const auto *home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+        return fmt::format("{}/.cache/cpp-lint-action", home);
+      }
+      return ".cpp-lint-action-cache";
+    }
+
+    // Files written for one run are best kept in memory.
+    auto default_scratch_dir() -> std::string {
+      if (auto ec = std::error_code{}; std::filesystem::is_directory("/dev/shm", ec)) {
+        return "/dev/shm";
+      }
+      return std::filesystem::temp_directory_path().string();
+    }
+
+    // Split comma separated globs. Empty globs are dropped.
+    auto split_globs(const std::string &globs) -> std::vector<std::string> {
+      auto res = std::vector<std::string>{};
+      for (auto glob: ranges::views::split(globs, ',') | ranges::to<std::vector<std::string>>()) {
+        auto trimmed = trim(glob);
+        if (!trimmed.empty()) {
+          res.emplace_back(trimmed);
+        }
+      }
+      return res;
+    }
   } // namespace
 
   using std::string;
@@ -45,6 +96,15 @@ namespace lint::program_options {
 
     const auto *level    = value<string>()->value_name("level")->default_value("info");
     const auto *revision = value<string>()->value_name("revision");
+    const auto *number   = value<std::size_t>()->value_name("number")->default_value(
+      usable_cpu_count());
+    const auto *dir      = value<string>()->value_name("dir")->default_value(default_cache_dir());
+    const auto *url      = value<string>()->value_name("url");
+    const auto *mebibyte = value<std::uint64_t>()->value_name("MiB")->default_value(512);
+    const auto *percent  = value<std::uint16_t>()->value_name("percent")->default_value(50);
+    const auto *limit    = value<std::size_t>()->value_name("number")->default_value(1000);
+    const auto *globs    = value<string>()->value_name("globs");
+    const auto *scratch  = value<string>()->value_name("dir")->default_value(default_scratch_dir());
 
     auto boolean = [](bool def) {
       return value<bool>()->value_name("bool")->default_value(def);
@@ -63,6 +123,34 @@ namespace lint::program_options {
       (enable_step_summary,         boolean(true),   "Whether enable write step summary to Github action")
       (enable_action_output,        boolean(true),   "Whether enable write output to Github action")
       (disable_errors,              boolean(false),  "Whether disable errors.")
+      (jobs,                        number,          "Set the maximum number of files checked "
+                                                     "concurrently. Defaults to the usable CPU count")
+      (cache_dir,                   dir,             "Set the directory where cpp-lint-action keeps data "
+                                                     "across runs, such as durations of checked files")
+      (enable_result_cache,         boolean(true),   "Whether reuse results of files which are checked "
+                                                     "with the same content and options before")
+      (result_cache_url,            url,             "Set the url of a remote result cache server shared "
+                                                     "by runners, such as cpp-lint-action-cache-server. "
+                                                     "Its token is read from $CPP_LINT_ACTION_CACHE_TOKEN")
+      (result_cache_max_size,       mebibyte,        "Set the size cap of the local result cache of each "
+                                                     "tool. Least recently used results are evicted "
+                                                     "beyond it. 0 means no cap")
+      (rename_threshold,            percent,         "Set the minimum similarity of a renamed file. Results "
+                                                     "of files renamed without changes are reused. "
+                                                     "Defaults to 0, which disables rename detection")
+      (rename_limit,                limit,           "Set the maximum number of files compared when "
+                                                     "detecting renames")
+      (include_paths,               globs,           "Set comma separated globs of paths to be checked, "
+                                                     "such as src/*,include/*. Other paths aren't even "
+                                                     "diffed. Defaults to files of enabled tools")
+      (exclude_paths,               globs,           "Set comma separated globs of paths never to be "
+                                                     "checked, such as third_party/*. They aren't even "
+                                                     "diffed")
+      (lint_from_odb,               boolean(false),  "Whether read files to check from the git object "
+                                                     "database instead of the working tree, so the source "
+                                                     "revision needn't be checked out")
+      (scratch_dir,                 scratch,         "Set the directory where files are written when linting "
+                                                     "from the object database. Defaults to /dev/shm")
     ;
     // clang-format on
 
@@ -108,6 +196,25 @@ namespace lint::program_options {
     });
   }
 
+  void fill_cache_context(const variables_map &variables, runtime_context &ctx) {
+    if (variables.contains(cache_dir)) {
+      ctx.cache_dir = variables[cache_dir].as<std::string>();
+    }
+    if (variables.contains(enable_result_cache)) {
+      ctx.enable_result_cache = variables[enable_result_cache].as<bool>();
+    }
+    if (variables.contains(result_cache_max_size)) {
+      constexpr auto mebibyte   = std::uint64_t{1024} * 1024;
+      ctx.result_cache_max_size = variables[result_cache_max_size].as<std::uint64_t>() * mebibyte;
+    }
+    if (variables.contains(result_cache_url)) {
+      ctx.result_cache_url = variables[result_cache_url].as<std::string>();
+    }
+    if (const auto *token = std::getenv(result_cache_token_env); token != nullptr) {
+      ctx.result_cache_token = token;
+    }
+  }
+
   // This function will be called after check context. So there's no need to do
   // same check.
   void fill_context(const variables_map &variables, runtime_context &ctx) {
@@ -131,6 +238,30 @@ namespace lint::program_options {
     if (variables.contains(disable_errors)) {
       ctx.disable_errors = variables[disable_errors].as<bool>();
     }
+    if (variables.contains(jobs)) {
+      ctx.jobs = variables[jobs].as<std::size_t>();
+      throw_if(ctx.jobs == 0, "jobs must be greater than 0");
+    }
+    if (variables.contains(rename_threshold)) {
+      ctx.rename_threshold = variables[rename_threshold].as<std::uint16_t>();
+      throw_if(ctx.rename_threshold > 100, "rename threshold must be at most 100");
+    }
+    if (variables.contains(rename_limit)) {
+      ctx.rename_limit = variables[rename_limit].as<std::size_t>();
+    }
+    if (variables.contains(include_paths)) {
+      ctx.include_paths = split_globs(variables[include_paths].as<std::string>());
+    }
+    if (variables.contains(exclude_paths)) {
+      ctx.exclude_paths = split_globs(variables[exclude_paths].as<std::string>());
+    }
+    if (variables.contains(lint_from_odb)) {
+      ctx.lint_from_odb = variables[lint_from_odb].as<bool>();
+    }
+    if (variables.contains(scratch_dir)) {
+      ctx.scratch_dir = variables[scratch_dir].as<std::string>();
+    }
+    fill_cache_context(variables, ctx);
   }
 
 } // namespace lint::program_options
@@ -37,6 +37,10 @@ namespace lint::program_options {
   /// Fill runtime context by program options.
   void fill_context(const variables_map &variables, runtime_context &ctx);
 
+  /// Fill only the result cache options into runtime context. Unlike
+  /// fill_context, this doesn't require a target revision.
+  void fill_cache_context(const variables_map &variables, runtime_context &ctx);
+
   /// Some options must be specified on the given condition, check it.
   void must_specify(const std::string &condition,
                     const variables_map &variables,
@@ -15,8 +15,24 @@
  */
 #pragma once
 
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <git2/diff.h>
+#include <range/v3/algorithm/any_of.hpp>
+#include <range/v3/algorithm/contains.hpp>
+#include <spdlog/spdlog.h>
+
+#include "context.h"
 #include "program_options.h"
+#include "tools/base_reporter.h"
 #include "tools/base_tool.h"
+#include "utils/common.h"
+#include "utils/pathspec.h"
+#include "utils/thread_pool.h"
+#include "utils/version_cache.h"
 
 namespace lint::tool {
   /// This class used to create tool and it's option.
@@ -28,8 +44,24 @@ namespace lint::tool {
     /// known what log level user want to use.
     virtual void register_option(program_options::options_description &desc) const = 0;
 
+    /// Return the name of the tool.
+    [[nodiscard]] virtual auto name() const -> std::string_view = 0;
+
+    /// Whether the tool is enabled by the user. It's cheap, since it doesn't
+    /// look for the tool binary.
+    [[nodiscard]] virtual auto is_enabled(const program_options::variables_map &variables) const
+      -> bool = 0;
+
+    /// Return the iregex of files checked by the tool, without creating it.
+    [[nodiscard]] virtual auto file_filter(const program_options::variables_map &variables) const
+      -> std::string = 0;
+
     /// Create tool instance.
     virtual auto create_tool(const program_options::variables_map &variables) -> tool_base_ptr = 0;
+
+    /// Versions of tool binaries probed by previous runs. Binaries are probed
+    /// every time if it's not set.
+    version_cache *versions = nullptr;
   };
 
   using creator_base_ptr = std::unique_ptr<creator_base>;
@@ -42,18 +74,98 @@ namespace lint::tool {
     }
   }
 
-  /// An utility to create enabled tools for multiple creators.
-  inline auto
-  create_enabled_tools(const std::vector<creator_base_ptr> &creators,
-                       program_options::variables_map &variables) -> std::vector<tool_base_ptr> {
-    auto res = std::vector<tool_base_ptr>{};
+  /// Make the pathspec of the diff from the include and exclude paths of the
+  /// context. Without include paths, files of enabled tools are included if
+  /// all their file filters can be expressed by globs.
+  inline auto make_diff_pathspec(const std::vector<creator_base_ptr> &creators,
+                                 const program_options::variables_map &variables,
+                                 const runtime_context &context) -> std::vector<std::string> {
+    auto includes = context.include_paths;
+    if (includes.empty()) {
+      for (const auto &creator: creators) {
+        if (!creator->is_enabled(variables)) {
+          continue;
+        }
+        auto globs = iregex_to_globs(creator->file_filter(variables));
+        if (!globs) {
+          spdlog::debug("diff all paths since file filter of {} isn't a glob", creator->name());
+          includes.clear();
+          break;
+        }
+        for (auto &glob: *globs) {
+          if (!ranges::contains(includes, glob)) {
+            includes.push_back(std::move(glob));
+          }
+        }
+      }
+    }
+    return make_pathspec(includes, context.exclude_paths);
+  }
+
+  /// Whether any changed file of the context should be checked by a tool
+  /// with the file filter. Deleted files are never checked.
+  inline auto has_files_to_check(const runtime_context &context, const std::string &iregex)
+    -> bool {
+    return ranges::any_of(context.changed_files, [&](const auto &file) {
+      return context.deltas.at(file).status != GIT_DELTA_DELETED && !filter_file(iregex, file);
+    });
+  }
+
+  /// An utility to create enabled tools for multiple creators. A slot is
+  /// returned for each enabled creator in order. Tools which have no changed
+  /// file to check are skipped without looking for their binaries, and their
+  /// slots hold reporters saying so. The other tools are created concurrently,
+  /// and versions of their binaries are cached in the cache directory.
+  inline auto create_enabled_tools(const std::vector<creator_base_ptr> &creators,
+                                   const program_options::variables_map &variables,
+                                   const runtime_context &context) -> std::vector<tool_slot> {
+    constexpr auto cache_dir = "cache-dir";
+
+    auto slots  = std::vector<tool_slot>{};
+    auto needed = std::vector<creator_base *>{};
     for (const auto &creator: creators) {
-      auto tool = creator->create_tool(variables);
-      if (tool) {
-        res.emplace_back(std::move(tool));
+      if (!creator->is_enabled(variables)) {
+        continue;
+      }
+      auto &slot = slots.emplace_back();
+      if (!has_files_to_check(context, creator->file_filter(variables))) {
+        spdlog::info("{} is skipped since no changed file should be checked by it",
+                     creator->name());
+        slot.skipped = std::make_unique<skipped_reporter>(std::string{creator->name()});
+        continue;
+      }
+      needed.push_back(creator.get());
+    }
+
+    auto store    = variables.contains(cache_dir)
+                    ? fmt::format("{}/versions.json", variables[cache_dir].as<std::string>())
+                    : std::string{};
+    auto versions = version_cache{store};
+
+    auto tools = std::vector<tool_base_ptr>(needed.size());
+    if (!needed.empty()) {
+      auto pool = thread_pool{needed.size()};
+      for (std::size_t i = 0; i < needed.size(); ++i) {
+        needed[i]->versions = &versions;
+        pool.submit([&, i] { tools[i] = needed[i]->create_tool(variables); });
+      }
+      pool.wait();
+    }
+    for (auto *creator: needed) {
+      creator->versions = nullptr;
+    }
+    versions.save();
+
+    // Fill created tools into the slots without skipped reporters in order.
+    // A slot of a creator which fails to create its tool is dropped.
+    auto next = tools.begin();
+    for (auto &slot: slots) {
+      if (!slot.skipped) {
+        slot.tool = std::move(*next++);
       }
     }
-    return res;
+    std::erase_if(slots, [](const auto &slot) { return !slot.tool && !slot.skipped; });
+    return slots;
   }
 
 } // namespace lint::tool
@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -33,6 +34,10 @@ namespace lint::tool {
     /// The executable binary of this tool.
     std::string binary;
 
+    /// The maximum number of this tool's jobs running at the same time. Zero
+    /// means this tool could use all workers.
+    std::size_t max_jobs = 0;
+
     /// Used to filt files.
     std::string file_filter_iregex = R"(.*\.(cpp|cc|c\+\+|cxx|c|cl|h|hpp|m|mm|inc))";
   };
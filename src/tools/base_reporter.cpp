@@ -16,10 +16,13 @@
 
 #include "tools/base_reporter.h"
 
+#include <fstream>
 #include <vector>
 #include <string>
 #include <string_view>
 
+#include <range/v3/algorithm/replace.hpp>
+
 #include "context.h"
 #include "github/client.h"
 #include "github/common.h"
@@ -54,9 +57,9 @@ namespace lint::tool {
       constexpr auto name = "[cpp-lint-action](https://github.com/emmett2020/cpp-lint-action)";
       const auto header   = fmt::format("# :boom: Analysis Report Generated by {}\n", name);
 
-      constexpr auto table_header   = "|  Tool  | Result | Passed | Failed | Ignored |\n"sv;
-      constexpr auto table_sep_line = "| ------ | -----  | ------ | ------ | ------- |\n"sv;
-      constexpr auto table_row_fmt  = "| **{}** |   {}   |   {}   |   {}   |   {}    |\n"sv;
+      constexpr auto table_header   = "|  Tool  | Result | Passed | Failed | Ignored | Cached |\n"sv;
+      constexpr auto table_sep_line = "| ------ | -----  | ------ | ------ | ------- | ------ |\n"sv;
+      constexpr auto table_row_fmt  = "| **{}** |   {}   |   {}   |   {}   |   {}    |   {}   |\n"sv;
       constexpr auto summary_fmt =
         "<summary> :mag_right: Click here to see the details of <strong>{}</strong> failed {} reported by <strong>{}</strong></summary>\n\n"sv;
       constexpr auto details_fmt = "<details>\n{}\n</details>\n"sv;
@@ -65,10 +68,15 @@ namespace lint::tool {
       auto details    = ""s;
       for (const auto &reporter: reporters) {
         auto [is_passed, successed, failed, ignored] = reporter->get_brief_result();
+        auto [hits, misses]                          = reporter->get_cache_stats();
         auto tool_name                               = reporter->tool_name();
 
-        const auto *icon  = is_passed ? " :white_check_mark: " : " :x: ";
-        table_rows       += fmt::format(table_row_fmt, tool_name, icon, successed, failed, ignored);
+        const auto *icon   = reporter->is_skipped() ? " skipped "
+                           : is_passed            ? " :white_check_mark: "
+                                                  : " :x: ";
+        auto cached        = hits + misses == 0 ? "-"s : fmt::format("{}/{}", hits, hits + misses);
+        table_rows        += fmt::format(
+          table_row_fmt, tool_name, icon, successed, failed, ignored, cached);
         if (!is_passed) {
           assert(failed != 0);
           auto summary =
@@ -87,6 +95,15 @@ namespace lint::tool {
 
   } // namespace
 
+  void skipped_reporter::write_to_action_output([[maybe_unused]] const runtime_context &context) {
+    auto output = env::get(github::github_output);
+    auto file   = std::fstream{output, std::ios::app};
+    throw_unless(file.is_open(), "error to open output file to write");
+    auto key = name;
+    ranges::replace(key, '-', '_');
+    file << fmt::format("{}_failed_number=0\n", key);
+  }
+
   bool all_passed(const std::vector<reporter_base_ptr> &reporters) {
     for (const auto &reporter: reporters) {
       auto [is_passed, successed, failed, ignored] = reporter->get_brief_result();
@@ -15,7 +15,11 @@
  */
 #pragma once
 
+#include <memory>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "context.h"
 #include "github/review_comment.h"
@@ -29,6 +33,9 @@ namespace lint::tool {
     /// Return a result sequence: is_pass, passed files number, failed files number, ignored files number.
     virtual auto get_brief_result() -> std::tuple<bool, std::size_t, std::size_t, std::size_t> = 0;
 
+    /// Return a result sequence: cache hits, cache misses.
+    virtual auto get_cache_stats() -> std::tuple<std::size_t, std::size_t> = 0;
+
     /// Return each file's result
     virtual auto get_detail_result(const runtime_context &context) -> std::string = 0;
 
@@ -41,10 +48,60 @@ namespace lint::tool {
 
     /// Used for output result show.
     virtual auto tool_name() -> std::string = 0;
+
+    /// Whether the tool is skipped since no changed file should be checked by
+    /// it.
+    virtual auto is_skipped() -> bool {
+      return false;
+    }
   };
 
   using reporter_base_ptr = std ::unique_ptr<reporter_base>;
 
+  /// The reporter of an enabled tool which is skipped since no changed file
+  /// should be checked by it. It's always passed.
+  struct skipped_reporter : reporter_base {
+    explicit skipped_reporter(std::string tool)
+      : name(std::move(tool)) {
+    }
+
+    auto get_brief_result() -> std::tuple<bool, std::size_t, std::size_t, std::size_t> override {
+      return {true, 0, 0, 0};
+    }
+
+    auto get_cache_stats() -> std::tuple<std::size_t, std::size_t> override {
+      return {0, 0};
+    }
+
+    auto get_detail_result([[maybe_unused]] const runtime_context &context)
+      -> std::string override {
+      return "";
+    }
+
+    auto make_review_comment([[maybe_unused]] const runtime_context &context)
+      -> github::review_comments override {
+      return {};
+    }
+
+    /// Write the same outputs as the tool, so that later steps needn't know
+    /// whether it's skipped.
+    void write_to_action_output(const runtime_context &context) override;
+
+    auto get_failed_commands() -> std::vector<std::string> override {
+      return {};
+    }
+
+    auto tool_name() -> std::string override {
+      return name;
+    }
+
+    auto is_skipped() -> bool override {
+      return true;
+    }
+
+    std::string name;
+  };
+
   bool all_passed(const std::vector<reporter_base_ptr> &reporters);
 
   void write_to_github_action_output(const runtime_context &context,
@@ -20,6 +20,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 namespace lint::tool {
 
   struct per_file_result_base {
@@ -30,6 +32,23 @@ namespace lint::tool {
     std::string file_option;
   };
 
+  /// Json conversions of the common fields, used by the result cache.
+  inline void to_json(nlohmann::json &json, const per_file_result_base &result) {
+    json["passed"]      = result.passed;
+    json["file_path"]   = result.file_path;
+    json["tool_stdout"] = result.tool_stdout;
+    json["tool_stderr"] = result.tool_stderr;
+    json["file_option"] = result.file_option;
+  }
+
+  inline void from_json(const nlohmann::json &json, per_file_result_base &result) {
+    json.at("passed").get_to(result.passed);
+    json.at("file_path").get_to(result.file_path);
+    json.at("tool_stdout").get_to(result.tool_stdout);
+    json.at("tool_stderr").get_to(result.tool_stderr);
+    json.at("file_option").get_to(result.file_option);
+  }
+
   using per_file_result_base_ptr = std::unique_ptr<per_file_result_base>;
 
   template <class PerFileResult>
@@ -42,6 +61,10 @@ namespace lint::tool {
     std::unordered_map<std::string, PerFileResult> fails;
 
     std::vector<std::string> failed_commands;
+
+    // Number of files whose results are served or missed by the result cache.
+    std::size_t cache_hits   = 0;
+    std::size_t cache_misses = 0;
   };
 
 } // namespace lint::tool
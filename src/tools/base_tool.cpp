@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/base_tool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+#include <spdlog/spdlog.h>
+
+#include "utils/thread_pool.h"
+
+namespace lint::tool {
+  namespace {
+    // Each (tool, job) pair is a node of the job graph. Nodes of the same tool
+    // are started in job order.
+    struct tool_state {
+      tool_base *tool      = nullptr;
+      std::size_t num_jobs = 0;
+      std::size_t next_job = 0;
+      std::size_t running  = 0;
+      std::size_t limit    = 0;
+      bool cancelled       = false;
+
+      [[nodiscard]] auto has_pending() const -> bool {
+        return !cancelled && next_job < num_jobs;
+      }
+
+      [[nodiscard]] auto is_runnable() const -> bool {
+        return has_pending() && (limit == 0 || running < limit);
+      }
+    };
+
+    struct job_graph {
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::vector<tool_state> states;
+
+      // Pick the runnable tool with the fewest running jobs, so that short
+      // jobs of cheap tools fill the workers left idle by expensive ones.
+      auto pick() -> tool_state * {
+        auto *picked = static_cast<tool_state *>(nullptr);
+        for (auto &state: states) {
+          if (state.is_runnable() && (picked == nullptr || state.running < picked->running)) {
+            picked = &state;
+          }
+        }
+        return picked;
+      }
+
+      [[nodiscard]] auto has_pending() const -> bool {
+        return ranges::any_of(states, [](const auto &state) { return state.has_pending(); });
+      }
+
+      void cancel_all() {
+        for (auto &state: states) {
+          state.cancelled = true;
+        }
+      }
+
+      void work(const runtime_context &context) {
+        while (true) {
+          auto *state = static_cast<tool_state *>(nullptr);
+          auto job    = std::size_t{0};
+          {
+            auto lock = std::unique_lock{mutex};
+            cv.wait(lock, [&] {
+              state = pick();
+              return state != nullptr || !has_pending();
+            });
+            if (state == nullptr) {
+              return;
+            }
+            job = state->next_job++;
+            ++state->running;
+          }
+
+          auto passed = false;
+          try {
+            passed = state->tool->run_job(context, job);
+          } catch (...) {
+            {
+              auto lock = std::lock_guard{mutex};
+              --state->running;
+              cancel_all();
+            }
+            cv.notify_all();
+            throw;
+          }
+
+          auto cancelled = false;
+          {
+            auto lock = std::lock_guard{mutex};
+            --state->running;
+            if (!passed && state->tool->fastly_exit() && !state->cancelled) {
+              spdlog::info("{} cancels its remaining jobs since check failed",
+                           state->tool->name());
+              state->cancelled = true;
+              cancelled        = true;
+            }
+          }
+          // Running jobs of the tool are stopped out of the lock, since they
+          // may still finish and take it.
+          if (cancelled) {
+            state->tool->cancel();
+          }
+          cv.notify_all();
+        }
+      }
+    };
+  } // namespace
+
+  void tool_base::check(const runtime_context &context) {
+    run_job_graph({this}, context);
+  }
+
+  void run_job_graph(const std::vector<tool_base *> &tools, const runtime_context &context) {
+    spdlog::trace("Enter run_job_graph()");
+    auto graph      = job_graph{};
+    auto total_jobs = std::size_t{0};
+    for (auto *tool: tools) {
+      auto &state    = graph.states.emplace_back();
+      state.tool     = tool;
+      state.num_jobs = tool->prepare(context);
+      state.limit    = tool->max_jobs();
+      total_jobs    += state.num_jobs;
+      spdlog::debug("{} has {} jobs", tool->name(), state.num_jobs);
+    }
+
+    if (total_jobs != 0) {
+      auto num_workers = std::min(context.jobs, total_jobs);
+      auto pool        = thread_pool{num_workers};
+      for (std::size_t i = 0; i < num_workers; ++i) {
+        pool.submit([&] { graph.work(context); });
+      }
+      pool.wait();
+    }
+
+    for (auto *tool: tools) {
+      tool->finish(context);
+    }
+  }
+
+  auto run_tools(const std::vector<tool_base_ptr> &tools, const runtime_context &context)
+    -> std::vector<reporter_base_ptr> {
+    auto raw_tools = std::vector<tool_base *>{};
+    for (const auto &tool: tools) {
+      raw_tools.push_back(tool.get());
+    }
+    run_job_graph(raw_tools, context);
+
+    auto ret = std::vector<reporter_base_ptr>{};
+    for (const auto &tool: tools) {
+      ret.emplace_back(tool->get_reporter());
+    }
+    return ret;
+  }
+
+  auto run_tools(std::vector<tool_slot> &slots, const runtime_context &context)
+    -> std::vector<reporter_base_ptr> {
+    auto raw_tools = std::vector<tool_base *>{};
+    for (const auto &slot: slots) {
+      if (slot.tool) {
+        raw_tools.push_back(slot.tool.get());
+      }
+    }
+    run_job_graph(raw_tools, context);
+
+    auto ret = std::vector<reporter_base_ptr>{};
+    for (auto &slot: slots) {
+      ret.emplace_back(slot.tool ? slot.tool->get_reporter() : std::move(slot.skipped));
+    }
+    return ret;
+  }
+
+} // namespace lint::tool
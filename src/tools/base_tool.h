@@ -15,6 +15,9 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include "context.h"
 #include "tools/base_reporter.h"
 #include "utils/platform.h"
@@ -22,6 +25,11 @@
 namespace lint::tool {
   /// This is a base class represents lint tools. All specified tools should be
   /// derived from this.
+  ///
+  /// A tool splits its work into independent jobs. prepare() tells how many
+  /// jobs there are, run_job() may then be called concurrently for different
+  /// jobs, and finish() collects the results in a deterministic order. This
+  /// lets the scheduler interleave jobs of different tools.
   struct tool_base {
     virtual ~tool_base() = default;
 
@@ -37,8 +45,36 @@ namespace lint::tool {
     /// Return binary path of this tool.
     virtual auto binary() -> std::string_view = 0;
 
-    /// Apply this tool to a single file.
-    virtual void check(const runtime_context &context) = 0;
+    /// Prepare to check the given context and return the number of jobs.
+    virtual auto prepare(const runtime_context &context) -> std::size_t = 0;
+
+    /// Run the job of the given index and return whether it passed. This may
+    /// be called concurrently for different jobs.
+    virtual auto run_job(const runtime_context &context, std::size_t job) -> bool = 0;
+
+    /// Collect the results of all finished jobs. Cancelled jobs are never run.
+    virtual void finish(const runtime_context &context) = 0;
+
+    /// The maximum number of this tool's jobs which could run at the same
+    /// time. Zero means no limit besides the global one.
+    virtual auto max_jobs() -> std::size_t {
+      return 0;
+    }
+
+    /// Whether the remaining jobs of this tool should be cancelled as soon as
+    /// one job fails.
+    virtual auto fastly_exit() -> bool {
+      return false;
+    }
+
+    /// Stop the running jobs after the remaining ones are cancelled by a failed
+    /// job. Stopped jobs report nothing, just like cancelled ones. It may be
+    /// called while other jobs run.
+    virtual void cancel() {
+    }
+
+    /// Apply this tool to all changed files of the given context.
+    virtual void check(const runtime_context &context);
 
     /// Return the result reporter. To get the result, you must first call check().
     virtual auto get_reporter() -> reporter_base_ptr = 0;
@@ -47,15 +83,24 @@ namespace lint::tool {
   /// An unique pointer for base tool.
   using tool_base_ptr = std::unique_ptr<tool_base>;
 
-  /// Run the given tools one by one and return the reporter of each tool in order.
-  inline auto run_tools(const std::vector<tool_base_ptr> &tools, const runtime_context &context)
-    -> std::vector<reporter_base_ptr> {
-    auto ret = std::vector<reporter_base_ptr>{};
-    for (const auto &tool: tools) {
-      tool->check(context);
-      ret.emplace_back(tool->get_reporter());
-    }
-    return ret;
-  }
+  /// Run all jobs of the given tools on a shared pool of `context.jobs`
+  /// workers, then call finish() of each tool in order.
+  void run_job_graph(const std::vector<tool_base *> &tools, const runtime_context &context);
+
+  /// Run the given tools concurrently and return the reporter of each tool in order.
+  auto run_tools(const std::vector<tool_base_ptr> &tools, const runtime_context &context)
+    -> std::vector<reporter_base_ptr>;
+
+  /// The tool created by an enabled creator, or the reporter of its tool if
+  /// the tool is skipped without being created.
+  struct tool_slot {
+    tool_base_ptr tool;
+    reporter_base_ptr skipped;
+  };
+
+  /// Run the tools of the given slots concurrently and return the reporter of
+  /// each slot in order. Reporters of skipped tools are moved out of slots.
+  auto run_tools(std::vector<tool_slot> &slots, const runtime_context &context)
+    -> std::vector<reporter_base_ptr>;
 
 } // namespace lint::tool
@@ -18,6 +18,9 @@
 #include "program_options.h"
 #include "tools/base_tool.h"
 #include "tools/clang_format/general/impl.h"
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+#  include "tools/clang_format/libformat/impl.h"
+#endif
 #include "tools/clang_format/version/v18.h"
 #include "tools/util.h"
 
@@ -30,16 +33,29 @@ namespace lint::tool::clang_format {
     constexpr auto version            = "clang-format-version";
     constexpr auto binary             = "clang-format-binary";
     constexpr auto file_iregex        = "clang-format-file-iregex";
+    constexpr auto jobs               = "clang-format-jobs";
+    constexpr auto batch_size         = "clang-format-batch-size";
+    constexpr auto engine             = "clang-format-engine";
+
+    constexpr auto process_engine   = "process";
+    constexpr auto libformat_engine = "libformat";
+
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+    constexpr auto with_libformat = true;
+#else
+    constexpr auto with_libformat = false;
+#endif
 
   } // namespace
 
   // Get version from clang-format output.
   // Example: Ubuntu clang-format version 18.1.3 (1ubuntu1)
-  auto get_version(const std::string &binary) -> std::string {
-    auto [ec, std_out, std_err] = shell::execute(binary, {"--version"});
-    if (ec != 0) {
+  auto get_version(const std::string &binary, version_cache *versions) -> std::string {
+    auto output = versions != nullptr ? versions->probe(binary) : probe_version(binary);
+    if (!output) {
       return "";
     }
+    const auto &std_out = *output;
     constexpr auto version_regex = R"(version\ (\d+\.\d+\.\d+))";
     auto regex                   = boost::regex{version_regex};
     auto match                   = boost::smatch{};
@@ -56,6 +72,10 @@ namespace lint::tool::clang_format {
     const auto *bin    = value<string>()->value_name("path");
     const auto *iregex = value<string>()->value_name("iregex")->default_value(
       option.file_filter_iregex);
+    const auto *number = value<std::size_t>()->value_name("number")->default_value(0);
+    const auto *batch  = value<std::size_t>()->value_name("number")->default_value(
+      option.batch_size);
+    const auto *eng    = value<string>()->value_name("engine")->default_value(option.engine);
 
     auto boolean = [](bool def) {
       return value<bool>()->value_name("bool")->default_value(def);
@@ -75,10 +95,32 @@ namespace lint::tool::clang_format {
                                            "Don't spefify both this option and the clang-format-version "
                                            "option to avoid ambigous")
     (file_iregex,         iregex,          "Set the source file filter for clang-format.")
+    (jobs,                number,          "Set the maximum number of clang-format processes "
+                                           "running at the same time. 0 means no limit besides "
+                                           "the global jobs option")
+    (batch_size,          batch,           "Set the number of files checked by one clang-format "
+                                           "process. Larger batches save the process startup cost "
+                                           "when many small files are changed")
+    (engine,              eng,             "Set how clang-format checks files. Supports: [process, "
+                                           "libformat]. libformat formats files inside "
+                                           "cpp-lint-action, which must be built with "
+                                           "CPP_LINT_ACTION_WITH_LIBFORMAT")
   ;
     // clang-format on
   }
 
+  auto creator::is_enabled(const program_options::variables_map &variables) const -> bool {
+    return variables[enable].as<bool>();
+  }
+
+  auto creator::file_filter(const program_options::variables_map &variables) const
+    -> std::string {
+    if (variables.contains(file_iregex)) {
+      return variables[file_iregex].as<std::string>();
+    }
+    return option.file_filter_iregex;
+  }
+
   void creator::create_option(const program_options::variables_map &variables) {
     spdlog::trace("Enter create_option()");
     option.enabled = variables[enable].as<bool>();
@@ -93,6 +135,29 @@ namespace lint::tool::clang_format {
     if (variables.contains(file_iregex)) {
       option.file_filter_iregex = variables[file_iregex].as<std::string>();
     }
+    if (variables.contains(jobs)) {
+      option.max_jobs = variables[jobs].as<std::size_t>();
+    }
+    if (variables.contains(batch_size)) {
+      option.batch_size = variables[batch_size].as<std::size_t>();
+      throw_if(option.batch_size == 0, "clang-format batch size must be greater than 0");
+    }
+
+    if (variables.contains(engine)) {
+      option.engine = variables[engine].as<std::string>();
+    }
+    if (option.engine == libformat_engine) {
+      throw_unless(with_libformat,
+                   "libformat engine requires building with CPP_LINT_ACTION_WITH_LIBFORMAT");
+      program_options::must_not_specify("use libformat engine", variables, {version, binary});
+      option.binary = "clang-format";
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+      option.version = libformat_version();
+#endif
+      return;
+    }
+    throw_unless(option.engine == process_engine,
+                 fmt::format("unsupported clang-format engine: {}", option.engine));
 
     // Get clang-format-binary
     if (variables.contains(version)) {
@@ -113,7 +178,7 @@ namespace lint::tool::clang_format {
       option.binary = std_out;
     }
 
-    option.version = get_version(option.binary);
+    option.version = get_version(option.binary, versions);
   }
 
   auto creator::create_tool(const program_options::variables_map &variables) -> tool_base_ptr {
@@ -126,6 +191,11 @@ namespace lint::tool::clang_format {
 
     auto version = option.version;
     auto tool    = tool_base_ptr{};
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+    if (option.engine == libformat_engine) {
+      return std::make_unique<clang_format_libformat>(option);
+    }
+#endif
     if (version == version_18_1_3) {
       tool = std::make_unique<clang_format_v18_1_3>(option);
     } else if (version == version_18_1_0) {
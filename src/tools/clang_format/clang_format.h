@@ -29,6 +29,15 @@ namespace lint::tool::clang_format {
     /// Register clang-format needed options to program options description.
     void register_option(program_options::options_description &desc) const override;
 
+    auto name() const -> std::string_view override {
+      return "clang-format";
+    }
+
+    auto is_enabled(const program_options::variables_map &variables) const -> bool override;
+
+    auto file_filter(const program_options::variables_map &variables) const
+      -> std::string override;
+
     /// Create clang-format option struct by user input program options.
     void create_option(const program_options::variables_map &variables);
 
@@ -41,7 +50,8 @@ namespace lint::tool::clang_format {
     option_t option;
   };
 
-  /// Get clang-format version based on clang-format output
-  auto get_version(const std::string &binary) -> std::string;
+  /// Get clang-format version based on clang-format output. The output is
+  /// served by `versions` if it's given.
+  auto get_version(const std::string &binary, version_cache *versions = nullptr) -> std::string;
 
 } // namespace lint::tool::clang_format
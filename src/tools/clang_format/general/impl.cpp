@@ -15,9 +15,9 @@
  */
 #include "tools/clang_format/general/impl.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstdint>
-#include <fstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -28,44 +28,14 @@
 
 #include "context.h"
 #include "tools/clang_format/general/reporter.h"
+#include "tools/util.h"
 #include "utils/common.h"
+#include "utils/git_utils.h"
 #include "utils/shell.h"
 
 namespace lint::tool::clang_format {
   namespace {
 
-    // Read a file and get this
-    auto get_line_lens(std::string_view file_path) -> std::vector<uint32_t> {
-      spdlog::trace("Enter clang_format::get_line_lens()");
-      constexpr auto line_feed_len = 1;
-
-      auto lines = std::vector<uint32_t>{};
-      auto file  = std::ifstream{file_path.data()};
-      throw_unless(file.is_open(), fmt::format("open file {} error", file_path));
-
-      auto temp = std::string{};
-      while (std::getline(file, temp)) {
-        lines.emplace_back(temp.size() + line_feed_len);
-      }
-      return lines;
-    }
-
-    // offset starts from 0 while row/col starts from 1
-    auto get_position(const std::vector<uint32_t> &lens, int offset)
-      -> std::tuple<int32_t, int32_t> {
-      spdlog::trace("Enter clang_format::get_position()");
-
-      auto cur_offset = uint32_t{0};
-      for (int i = 0; i < lens.size(); ++i) {
-        auto len = lens[i];
-        if (offset >= cur_offset && offset < cur_offset + len) {
-          return {i + 1, offset - cur_offset + 1};
-        }
-        cur_offset += len;
-      }
-      return {-1, -1};
-    }
-
     inline auto xml_error(tinyxml2::XMLError err) -> std::string_view {
       return tinyxml2::XMLDocument::ErrorIDToName(err);
     }
@@ -77,7 +47,7 @@ namespace lint::tool::clang_format {
     auto parse_replacements_xml(
       const runtime_context &ctx,
       std::string_view data,
-      std::string_view file) -> replacements_t {
+      const std::string &file) -> replacements_t {
       spdlog::trace("Enter clang_format_general::parse_replacements_xml()");
 
       // Names in replacements xml file.
@@ -101,7 +71,7 @@ namespace lint::tool::clang_format {
                "Parse replacements xml failed since no child names 'replacements'");
       auto replacements = replacements_t{};
 
-      const auto lens = get_line_lens(fmt::format("{}/{}", ctx.repo_path, file));
+      const auto &lines = ctx.snapshot(file).lines();
 
       // Empty replacement node is allowd here.
       auto *replacement_ele = replacements_ele->FirstChildElement(replacement_str);
@@ -114,7 +84,7 @@ namespace lint::tool::clang_format {
           replacement.data = text;
         }
 
-        auto [row, col] = get_position(lens, replacement.offset);
+        auto [row, col] = lines.position(static_cast<std::size_t>(replacement.offset));
         replacement.row = row;
         replacement.col = col;
         if (!replacements.contains(row)) {
@@ -134,14 +104,44 @@ namespace lint::tool::clang_format {
       return tool_opt;
     }
 
-    auto execute(const option_t &opt, std::string_view repo, std::string_view file)
-      -> std::tuple<shell::result, std::string> {
+    auto execute(const shell::process_group &processes,
+                 const option_t &opt,
+                 std::string_view repo,
+                 std::string_view file) -> std::tuple<shell::result, std::string> {
       spdlog::trace("Enter clang_format_general::execute()");
       auto tool_opt     = make_replacements_options(file);
       auto tool_opt_str = concat(tool_opt, ' ');
       spdlog::info("Running command: {} {}", opt.binary, tool_opt_str);
 
-      return {shell::execute(opt.binary, tool_opt, repo), tool_opt_str};
+      return {processes.execute(opt.binary, tool_opt, repo), tool_opt_str};
+    }
+
+    // Run one clang-format process for all given files.
+    auto execute(const shell::process_group &processes,
+                 const option_t &opt,
+                 std::string_view repo,
+                 const std::vector<std::string> &files) -> shell::result {
+      spdlog::trace("Enter clang_format_general::execute()");
+      auto tool_opt = std::vector<std::string>{"--output-replacements-xml"};
+      tool_opt.insert(tool_opt.end(), files.begin(), files.end());
+      spdlog::info("Running command: {} {}", opt.binary, concat(tool_opt, ' '));
+      return processes.execute(opt.binary, tool_opt, repo);
+    }
+
+    // clang-format prints a replacements xml document for each file in order.
+    // Each document starts with an xml declaration, which can't appear inside
+    // a document since '<' of replacement text is escaped.
+    auto split_replacements_xml(std::string_view data) -> std::vector<std::string_view> {
+      constexpr auto declaration = std::string_view{"<?xml"};
+
+      auto documents = std::vector<std::string_view>{};
+      auto start     = data.find(declaration);
+      while (start != std::string_view::npos) {
+        auto next = data.find(declaration, start + declaration.size());
+        documents.push_back(data.substr(start, next - start));
+        start = next;
+      }
+      return documents;
     }
 
   } // namespace
@@ -152,12 +152,13 @@ namespace lint::tool::clang_format {
     const std::string &file) const -> per_file_result {
     spdlog::trace("Enter clang_format_general::check_single_file()");
 
-    auto [xml_res, file_opt] = execute(option, root_dir, file);
+    auto [xml_res, file_opt] = execute(processes, option, root_dir, file);
     auto result              = per_file_result{};
     result.file_path         = file;
     result.tool_stdout       = xml_res.std_out;
     result.tool_stderr       = xml_res.std_err;
     result.file_option       = file_opt;
+    result.exit_code         = xml_res.exit_code;
     if (xml_res.exit_code != 0) {
       result.passed = false;
       return result;
@@ -169,44 +170,137 @@ namespace lint::tool::clang_format {
     return result;
   }
 
-  void clang_format_general::check(const runtime_context &context) {
-    assert(!option.binary.empty() && "clang-format binary is empty");
-    assert(!context.repo_path.empty() && "the repo_path of context is empty");
+  auto clang_format_general::check_files(const runtime_context &context,
+                                         const std::string &root_dir,
+                                         const std::vector<std::string> &files) const
+    -> std::vector<per_file_result> {
+    spdlog::trace("Enter clang_format_general::check_files()");
+    auto results = std::vector<per_file_result>{};
+    if (files.size() == 1) {
+      results.push_back(check_single_file(context, root_dir, files.front()));
+      return results;
+    }
 
-    const auto root_dir = context.repo_path;
-    const auto files    = context.changed_files;
-    for (const auto &file: files) {
-      const auto &delta = context.deltas.at(file);
-      if (delta.status == GIT_DELTA_DELETED) {
-        continue;
+    // If the batch fails, it's unknown which files fail. So check them one by
+    // one to keep the same result as checking files separately.
+    auto xml_res   = execute(processes, option, root_dir, files);
+    auto documents = split_replacements_xml(xml_res.std_out);
+    if (xml_res.exit_code != 0 || documents.size() != files.size()) {
+      spdlog::debug("clang-format batch failed, check {} files one by one", files.size());
+      for (const auto &file: files) {
+        results.push_back(check_single_file(context, root_dir, file));
       }
-      if (filter_file(option.file_filter_iregex, file)) {
-        result.ignored.push_back(file);
-        spdlog::debug("file {} is ignored by {}", file, option.binary);
-        continue;
+      return results;
+    }
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      auto &result        = results.emplace_back();
+      auto replacements   = parse_replacements_xml(context, std::string{documents[i]}, files[i]);
+      result.file_path    = files[i];
+      result.tool_stdout  = documents[i];
+      result.tool_stderr  = xml_res.std_err;
+      result.file_option  = concat(make_replacements_options(files[i]), ' ');
+      result.passed       = replacements.empty();
+      result.replacements = std::move(replacements);
+    }
+    return results;
+  }
+
+  auto clang_format_general::cache_key(const runtime_context &context,
+                                       const std::string &file,
+                                       std::string_view as_path) const
+    -> std::optional<std::string> {
+    const auto &id = context.snapshot(file).id();
+    if (git::oid::is_zero(id)) {
+      return std::nullopt;
+    }
+    auto builder = cache::key_builder{};
+    builder.add("clang-format").add(option.engine).add(option.version).add(option.binary);
+    builder.add(as_path.empty() ? std::string_view{file} : as_path).add(id);
+
+    // Parent configs are read by InheritParentConfig, and ignore files of all
+    // parent directories apply to the file. Each chain is prefixed by its
+    // length, so configs never move between chains.
+    const auto &root = context.work_dir();
+    auto configs     = cache::config_chain(root, file, {".clang-format", "_clang-format"});
+    auto ignores     = cache::config_chain(root, file, {".clang-format-ignore"});
+    for (const auto *chain: {&configs, &ignores}) {
+      builder.add(std::to_string(chain->size()));
+      for (const auto &config: *chain) {
+        builder.add(config);
       }
+    }
+    return builder.build();
+  }
 
-      auto per_file_result = check_single_file(context, root_dir, file);
-      if (per_file_result.passed) {
-        spdlog::info("file: {} passes {} check.", file, option.binary);
-        result.passes[file] = std::move(per_file_result);
-        continue;
+  auto clang_format_general::prepare(const runtime_context &context) -> std::size_t {
+    spdlog::trace("Enter clang_format_general::prepare()");
+    assert(!option.binary.empty() && "clang-format binary is empty");
+    assert(!context.repo_path.empty() && "the repo_path of context is empty");
+    assert(option.batch_size != 0 && "the batch size of clang-format is 0");
+
+    files        = collect_files(context, option, result);
+    file_results = std::vector<std::optional<per_file_result>>(files.size());
+    cache_keys   = std::vector<std::optional<std::string>>(files.size());
+    pending      = ranges::views::iota(std::size_t{0}, files.size()) | ranges::to<std::vector>();
+    cache        = open_result_cache(context, "clang-format");
+    if (cache) {
+      auto old_keys = std::vector<std::optional<std::string>>(files.size());
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        cache_keys[i] = cache_key(context, files[i]);
+        if (auto old_path = moved_from(context, files[i])) {
+          old_keys[i] = cache_key(context, files[i], *old_path);
+        }
       }
+      pending = lookup_cached_results(*cache, cache_keys, file_results, result);
+
+      // Replacements only depend on the content, so results of moved files are
+      // taken over by their new paths.
+      auto relocate = [&](per_file_result &moved, std::size_t index) {
+        moved.file_path   = files[index];
+        moved.file_option = concat(make_replacements_options(files[index]), ' ');
+      };
+      pending = lookup_moved_results<per_file_result>(
+        *cache, pending, cache_keys, old_keys, file_results, result, relocate);
+    }
+    return (pending.size() + option.batch_size - 1) / option.batch_size;
+  }
 
-      spdlog::error("file: {} doesn't pass {} check.", file, option.binary);
-      result.failed_commands.emplace_back(
-        fmt::format("clang-format {}", per_file_result.file_option));
-      result.fails[file] = std::move(per_file_result);
+  auto clang_format_general::run_job(const runtime_context &context, std::size_t job) -> bool {
+    auto first       = job * option.batch_size;
+    auto last        = std::min(first + option.batch_size, pending.size());
+    auto batch_files = std::vector<std::string>{};
+    for (auto i = first; i < last; ++i) {
+      batch_files.push_back(files[pending[i]]);
+    }
 
-      if (option.enabled_fastly_exit) {
-        spdlog::info("{} fastly exit since check failed", option.binary);
-        result.final_passed  = false;
-        result.fastly_exited = true;
-        return;
+    auto results = check_files(context, context.work_dir(), batch_files);
+    if (processes.killed()) {
+      // Results of killed runs are incomplete, so they're neither cached nor
+      // reported.
+      return true;
+    }
+
+    auto passed = true;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      auto index = pending[first + i];
+      passed     = passed && results[i].passed;
+      // A failed run, such as of an unreadable file, shouldn't be replayed by
+      // later runs.
+      if (cache && cache_keys[index] && results[i].exit_code == 0) {
+        cache->put(*cache_keys[index], results[i]);
       }
+      file_results[index] = std::move(results[i]);
     }
+    return passed;
+  }
+
+  void clang_format_general::cancel() {
+    processes.kill();
+  }
 
-    result.final_passed = result.fails.empty();
+  void clang_format_general::finish([[maybe_unused]] const runtime_context &context) {
+    merge_results(result, file_results, option.enabled_fastly_exit, "clang-format", option.binary);
   }
 
   auto clang_format_general::get_reporter() -> reporter_base_ptr {
@@ -15,13 +15,19 @@
  */
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "cache/result_cache.h"
 #include "tools/base_reporter.h"
 #include "tools/base_tool.h"
 #include "tools/clang_format/general/option.h"
 #include "tools/clang_format/general/result.h"
+#include "utils/shell.h"
 
 namespace lint::tool::clang_format {
   /// The general implementation of clang-format.
@@ -50,12 +56,53 @@ namespace lint::tool::clang_format {
                            const std::string &root_dir,
                            const std::string &file) const -> per_file_result;
 
-    void check(const runtime_context &context) override;
+    /// Check all given files by one clang-format process. The replacements
+    /// of each file are split from its output.
+    virtual auto check_files(const runtime_context &context,
+                             const std::string &root_dir,
+                             const std::vector<std::string> &files) const
+      -> std::vector<per_file_result>;
+
+    /// Return the result cache key of the file, or std::nullopt if the file
+    /// content isn't known by git. If `as_path` is given, the key is made as if
+    /// the file lives there, which finds results of a file before it's moved.
+    /// The config is still the one applied to the current path.
+    auto cache_key(const runtime_context &context,
+                   const std::string &file,
+                   std::string_view as_path = {}) const -> std::optional<std::string>;
+
+    auto prepare(const runtime_context &context) -> std::size_t override;
+
+    auto run_job(const runtime_context &context, std::size_t job) -> bool override;
+
+    void finish(const runtime_context &context) override;
+
+    auto max_jobs() -> std::size_t override {
+      return option.max_jobs;
+    }
+
+    auto fastly_exit() -> bool override {
+      return option.enabled_fastly_exit;
+    }
+
+    void cancel() override;
 
     auto get_reporter() -> reporter_base_ptr override;
 
     option_t option;
     result_t result;
+
+    // Files to be checked and their results. Files which aren't served by the
+    // result cache are pending, and each job checks a batch of consecutive
+    // pending files.
+    std::vector<std::string> files;
+    std::vector<std::optional<per_file_result>> file_results;
+    std::vector<std::size_t> pending;
+    std::vector<std::optional<std::string>> cache_keys;
+    std::unique_ptr<cache::result_cache> cache;
+
+    // All clang-format processes, which are killed together on fastly exit.
+    shell::process_group processes;
   };
 
 } // namespace lint::tool::clang_format
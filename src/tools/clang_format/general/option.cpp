@@ -26,6 +26,9 @@ namespace lint::tool::clang_format {
     spdlog::debug("version: {}", option.version);
     spdlog::debug("binary: {}", option.binary);
     spdlog::debug("file-filter-iregex: {}", option.file_filter_iregex);
+    spdlog::debug("max-jobs: {}", option.max_jobs);
+    spdlog::debug("batch-size: {}", option.batch_size);
+    spdlog::debug("engine: {}", option.engine);
     spdlog::debug("enable-warning-as-error: {}", option.enable_warning_as_error);
     spdlog::debug("");
   }
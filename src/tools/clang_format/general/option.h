@@ -20,6 +20,8 @@
 namespace lint::tool::clang_format {
   struct option_t : option_base {
     bool enable_warning_as_error = false;
+    std::size_t batch_size       = 1;
+    std::string engine           = "process";
   };
 
   void print_option(const option_t& option);
@@ -44,6 +44,10 @@ namespace lint::tool::clang_format {
               result.ignored.size()};
     }
 
+    auto get_cache_stats() -> std::tuple<std::size_t, std::size_t> override {
+      return {result.cache_hits, result.cache_misses};
+    }
+
     auto get_detail_result([[maybe_unused]] const runtime_context &context)
       -> std::string override {
       auto content = ""s;
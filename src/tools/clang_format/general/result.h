@@ -17,6 +17,8 @@
 
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 #include "tools/base_result.h"
 
 namespace lint::tool::clang_format {
@@ -36,7 +38,25 @@ namespace lint::tool::clang_format {
   struct per_file_result : per_file_result_base {
     replacements_t replacements;
     std::string formatted_source_code;
+
+    // The exit code of clang-format. It isn't cached, since results of failed
+    // runs are never stored.
+    int exit_code = 0;
   };
 
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(replacement_t, offset, length, data, row, col)
+
+  inline void to_json(nlohmann::json &json, const per_file_result &result) {
+    to_json(json, static_cast<const per_file_result_base &>(result));
+    json["replacements"]          = result.replacements;
+    json["formatted_source_code"] = result.formatted_source_code;
+  }
+
+  inline void from_json(const nlohmann::json &json, per_file_result &result) {
+    from_json(json, static_cast<per_file_result_base &>(result));
+    json.at("replacements").get_to(result.replacements);
+    json.at("formatted_source_code").get_to(result.formatted_source_code);
+  }
+
   using result_t = multi_files_result_base<per_file_result>;
 } // namespace lint::tool::clang_format
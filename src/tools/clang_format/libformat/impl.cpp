@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_format/libformat/impl.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <clang/Basic/Version.h>
+#include <clang/Format/Format.h>
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/Support/Error.h>
+#include <spdlog/spdlog.h>
+
+#include "tools/util.h"
+#include "utils/error.h"
+#include "utils/line_index.h"
+
+namespace lint::tool::clang_format {
+  namespace {
+    auto to_replacements(const clang::tooling::Replacements &replaces, const line_index &lines)
+      -> replacements_t {
+      auto replacements = replacements_t{};
+      for (const auto &replace: replaces) {
+        auto replacement   = replacement_t{};
+        replacement.offset = static_cast<int>(replace.getOffset());
+        replacement.length = static_cast<int>(replace.getLength());
+        replacement.data   = replace.getReplacementText().str();
+
+        auto [row, col] = lines.position(replace.getOffset());
+        replacement.row = row;
+        replacement.col = col;
+        replacements[row].emplace_back(std::move(replacement));
+      }
+      return replacements;
+    }
+  } // namespace
+
+  clang_format_libformat::clang_format_libformat(option_t opt)
+    : clang_format_general(std::move(opt)) {
+  }
+
+  clang_format_libformat::~clang_format_libformat() = default;
+
+  auto clang_format_libformat::get_style(const std::string &file_path,
+                                         std::string_view code) const
+    -> const clang::format::FormatStyle & {
+    auto language = clang::format::guessLanguage(file_path, code);
+    auto key      = fmt::format("{}:{}",
+                           std::filesystem::path{file_path}.parent_path().string(),
+                           static_cast<int>(language));
+
+    auto lock = std::lock_guard{styles_mutex_};
+    if (auto iter = styles_.find(key); iter != styles_.end()) {
+      return *iter->second;
+    }
+
+    auto style = clang::format::getStyle("file", file_path, "LLVM", code);
+    throw_unless(static_cast<bool>(style),
+                 [&]() noexcept { return llvm::toString(style.takeError()); });
+    spdlog::debug("load clang-format style for {}", key);
+    auto &cached = styles_[key];
+    cached       = std::make_unique<clang::format::FormatStyle>(std::move(*style));
+    return *cached;
+  }
+
+  auto clang_format_libformat::check_file(const runtime_context &context,
+                                          const std::string &root_dir,
+                                          const std::string &file) const -> per_file_result {
+    spdlog::trace("Enter clang_format_libformat::check_file()");
+    auto file_path     = fmt::format("{}/{}", root_dir, file);
+    const auto &source = context.snapshot(file);
+    auto code          = source.content();
+    const auto &style  = get_style(file_path, code);
+
+    // Same as clang-format: sort includes first, then format the sorted code.
+    auto ranges   = std::vector<clang::tooling::Range>{clang::tooling::Range(0, code.size())};
+    auto replaces = clang::format::sortIncludes(style, code, ranges, file_path);
+    auto sorted   = clang::tooling::applyAllReplacements(code, replaces);
+    throw_unless(static_cast<bool>(sorted),
+                 [&]() noexcept { return llvm::toString(sorted.takeError()); });
+
+    ranges      = clang::tooling::calculateRangesAfterReplacements(replaces, ranges);
+    auto status = clang::format::FormattingAttemptStatus{};
+    replaces    = replaces.merge(clang::format::reformat(style, *sorted, ranges, file_path, &status));
+    if (!status.FormatComplete) {
+      spdlog::debug("file {} is incompletely formatted since syntax errors", file);
+    }
+
+    auto result         = per_file_result{};
+    result.file_path    = file;
+    result.file_option  = fmt::format("--output-replacements-xml {}", file);
+    result.replacements = to_replacements(replaces, source.lines());
+    result.passed       = result.replacements.empty();
+    return result;
+  }
+
+  auto clang_format_libformat::check_files(const runtime_context &context,
+                                           const std::string &root_dir,
+                                           const std::vector<std::string> &files) const
+    -> std::vector<per_file_result> {
+    auto results = std::vector<per_file_result>{};
+    for (const auto &file: files) {
+      results.push_back(check_file(context, root_dir, file));
+    }
+    return results;
+  }
+
+  auto libformat_version() -> std::string {
+    return CLANG_VERSION_STRING;
+  }
+
+} // namespace lint::tool::clang_format
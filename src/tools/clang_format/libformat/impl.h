@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tools/clang_format/general/impl.h"
+
+namespace clang::format {
+  struct FormatStyle;
+} // namespace clang::format
+
+namespace lint::tool::clang_format {
+  /// The clang-format implementation which formats files in process by
+  /// libFormat, instead of spawning clang-format and parsing its xml output.
+  struct clang_format_libformat : clang_format_general {
+    explicit clang_format_libformat(option_t opt);
+    ~clang_format_libformat() override;
+
+    clang_format_libformat(const clang_format_libformat &)            = delete;
+    clang_format_libformat &operator=(const clang_format_libformat &) = delete;
+    clang_format_libformat(clang_format_libformat &&)                 = delete;
+    clang_format_libformat &operator=(clang_format_libformat &&)      = delete;
+
+    auto check_file(const runtime_context &context,
+                    const std::string &root_dir,
+                    const std::string &file) const -> per_file_result;
+
+    auto check_files(const runtime_context &context,
+                     const std::string &root_dir,
+                     const std::vector<std::string> &files) const
+      -> std::vector<per_file_result> override;
+
+  private:
+    // Find the style of the given file. Styles are cached by directory and
+    // language, so .clang-format files are only looked up once per directory.
+    auto get_style(const std::string &file_path, std::string_view code) const
+      -> const clang::format::FormatStyle &;
+
+    mutable std::mutex styles_mutex_;
+    mutable std::unordered_map<std::string, std::unique_ptr<clang::format::FormatStyle>> styles_;
+  };
+
+  /// Get the version of the linked libFormat.
+  auto libformat_version() -> std::string;
+
+} // namespace lint::tool::clang_format
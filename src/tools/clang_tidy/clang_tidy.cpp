@@ -18,6 +18,7 @@
 
 #include <boost/program_options.hpp>
 
+#include "tools/clang_tidy/clangd/impl.h"
 #include "tools/clang_tidy/general/option.h"
 #include "tools/clang_tidy/version/v18.h"
 #include "tools/util.h"
@@ -37,15 +38,27 @@ namespace lint::tool::clang_tidy {
     constexpr auto config_file          = "clang-tidy-config-file";
     constexpr auto header_filter        = "clang-tidy-header-filter";
     constexpr auto line_filter          = "clang-tidy-line-filter";
+    constexpr auto jobs                 = "clang-tidy-jobs";
+    constexpr auto batch_size           = "clang-tidy-batch-size";
+    constexpr auto engine               = "clang-tidy-engine";
+    constexpr auto clangd_binary        = "clang-tidy-clangd-binary";
+    constexpr auto cache_mode           = "clang-tidy-cache-mode";
+
+    constexpr auto process_engine = "process";
+    constexpr auto clangd_engine  = "clangd";
+
+    constexpr auto closure_cache_mode      = "closure";
+    constexpr auto preprocessed_cache_mode = "preprocessed";
   } // namespace
 
   // Get version from clang-tidy output.
   // Example: Ubuntu LLVM version 18.1.3
-  auto get_version(const std::string &binary) -> std::string {
-    auto [ec, std_out, std_err] = shell::execute(binary, {"--version"});
-    if (ec != 0) {
+  auto get_version(const std::string &binary, version_cache *versions) -> std::string {
+    auto output = versions != nullptr ? versions->probe(binary) : probe_version(binary);
+    if (!output) {
       return "";
     }
+    const auto &std_out = *output;
     constexpr auto version_regex = R"(version\ (\d+\.\d+\.\d+))";
     auto regex                   = boost::regex{version_regex};
     auto match                   = boost::smatch{};
@@ -61,7 +74,13 @@ namespace lint::tool::clang_tidy {
     const auto *bin    = value<std::string>()->value_name("path");
     const auto *iregex = value<std::string>()->value_name("iregex")->default_value(
       option.file_filter_iregex);
-    const auto *db = value<std::string>()->value_name("path")->default_value("build");
+    const auto *db     = value<std::string>()->value_name("path")->default_value("build");
+    const auto *number = value<std::size_t>()->value_name("number")->default_value(0);
+    const auto *batch  = value<std::size_t>()->value_name("number")->default_value(
+      option.batch_size);
+    const auto *eng    = value<std::string>()->value_name("engine")->default_value(option.engine);
+    const auto *clangd = value<std::string>()->value_name("path");
+    const auto *mode   = value<std::string>()->value_name("mode")->default_value(option.cache_mode);
 
     auto boolean = [](bool def) {
       return value<bool>()->value_name("bool")->default_value(def);
@@ -94,10 +113,39 @@ namespace lint::tool::clang_tidy {
       (config_file,           str(),           "Same as clang-tidy config-file option")
       (header_filter,         str(),           "Same as clang-tidy header-filter option")
       (line_filter,           str(),           "Same as clang-tidy line-filter option")
+      (jobs,                  number,          "Set the maximum number of clang-tidy processes "
+                                               "running at the same time. 0 means no limit besides "
+                                               "the global jobs option")
+      (batch_size,            batch,           "Set the number of files checked by one clang-tidy "
+                                               "process. Larger batches save the startup cost of "
+                                               "clang-tidy, such as loading the compilation database")
+      (engine,                eng,             "Set how clang-tidy checks files. Supports: [process, "
+                                               "clangd]. clangd checks all files by one long-lived "
+                                               "clangd, which reuses preambles of shared headers. "
+                                               "It reads checks from .clang-tidy files only")
+      (clangd_binary,         clangd,          "Set the full path of clangd executable binary used by "
+                                               "the clangd engine. Defaults to clangd in $PATH")
+      (cache_mode,            mode,            "Set how cached clang-tidy results are validated. "
+                                               "Supports: [closure, preprocessed]. closure compares "
+                                               "hashes of included files recorded after the check. "
+                                               "preprocessed hashes the -E output of each file "
+                                               "before the check, which also covers macros")
     ;
     // clang-format on
   }
 
+  auto creator::is_enabled(const program_options::variables_map &variables) const -> bool {
+    return variables[enable].as<bool>();
+  }
+
+  auto creator::file_filter(const program_options::variables_map &variables) const
+    -> std::string {
+    if (variables.contains(file_iregex)) {
+      return variables[file_iregex].as<std::string>();
+    }
+    return option.file_filter_iregex;
+  }
+
   void creator::create_option(const program_options::variables_map &variables) {
     spdlog::trace("Enter create_option()");
     option.enabled = variables[enable].as<bool>();
@@ -129,7 +177,7 @@ namespace lint::tool::clang_tidy {
       option.binary = std_out;
     }
 
-    option.version = get_version(option.binary);
+    option.version = get_version(option.binary, versions);
 
     if (variables.contains(file_iregex)) {
       option.file_filter_iregex = variables[file_iregex].as<std::string>();
@@ -158,6 +206,34 @@ namespace lint::tool::clang_tidy {
     if (variables.contains(line_filter)) {
       option.line_filter = variables[line_filter].as<std::string>();
     }
+    if (variables.contains(jobs)) {
+      option.max_jobs = variables[jobs].as<std::size_t>();
+    }
+    if (variables.contains(batch_size)) {
+      option.batch_size = variables[batch_size].as<std::size_t>();
+      throw_if(option.batch_size == 0, "clang-tidy batch size must be greater than 0");
+    }
+    if (variables.contains(engine)) {
+      option.engine = variables[engine].as<std::string>();
+    }
+    throw_unless(option.engine == process_engine || option.engine == clangd_engine,
+                 fmt::format("unsupported clang-tidy engine: {}", option.engine));
+    if (variables.contains(cache_mode)) {
+      option.cache_mode = variables[cache_mode].as<std::string>();
+    }
+    throw_unless(
+      option.cache_mode == closure_cache_mode || option.cache_mode == preprocessed_cache_mode,
+      fmt::format("unsupported clang-tidy cache mode: {}", option.cache_mode));
+    if (option.engine == clangd_engine) {
+      auto clangd = variables.contains(clangd_binary) ? variables[clangd_binary].as<std::string>()
+                                                      : std::string{"clangd"};
+      auto [ec, std_out, std_err] = shell::which(clangd);
+      throw_unless(ec == 0, fmt::format("Can't find clangd binary: {}", clangd));
+      option.clangd_binary = std_out;
+      if (!option.checks.empty() || !option.config.empty() || !option.config_file.empty()) {
+        spdlog::warn("clangd engine ignores checks and config options, use .clang-tidy instead");
+      }
+    }
   }
 
   auto creator::create_tool(const program_options::variables_map &variables) -> tool_base_ptr {
@@ -170,7 +246,9 @@ namespace lint::tool::clang_tidy {
 
     auto version = option.version;
     auto tool    = tool_base_ptr{};
-    if (version == version_18_1_3) {
+    if (option.engine == clangd_engine) {
+      tool = std::make_unique<clang_tidy_clangd>(option);
+    } else if (version == version_18_1_3) {
       tool = std::make_unique<clang_tidy_v18_1_3>(option);
     } else if (version == version_18_1_0) {
       tool = std::make_unique<clang_tidy_v18_1_0>(option);
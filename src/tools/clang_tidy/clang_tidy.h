@@ -27,6 +27,15 @@ namespace lint::tool::clang_tidy {
     /// Register clang-tidy needed options to program options description.
     void register_option(program_options::options_description &desc) const override;
 
+    auto name() const -> std::string_view override {
+      return "clang-tidy";
+    }
+
+    auto is_enabled(const program_options::variables_map &variables) const -> bool override;
+
+    auto file_filter(const program_options::variables_map &variables) const
+      -> std::string override;
+
     /// Create clang-tidy option struct by user input program options.
     void create_option(const program_options::variables_map &variables);
 
@@ -39,7 +48,8 @@ namespace lint::tool::clang_tidy {
     option_t option;
   };
 
-  /// Get clang-format version based on clang-format output
-  auto get_version(const std::string &binary) -> std::string;
+  /// Get clang-tidy version based on clang-tidy output. The output is
+  /// served by `versions` if it's given.
+  auto get_version(const std::string &binary, version_cache *versions = nullptr) -> std::string;
 } // namespace lint::tool::clang_tidy
 
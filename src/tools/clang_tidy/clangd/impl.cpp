@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tools/clang_tidy/clangd/impl.h"
+
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include "tools/util.h"
+#include "utils/error.h"
+#include "utils/lsp.h"
+#include "utils/shell.h"
+
+namespace lint::tool::clang_tidy {
+  namespace {
+    using json = nlohmann::json;
+
+    auto make_clangd_options(const option_t &option, std::size_t workers)
+      -> std::vector<std::string> {
+      auto opts = std::vector<std::string>{};
+      opts.emplace_back("--clang-tidy");
+      opts.emplace_back("--log=error");
+      opts.emplace_back("--background-index=false");
+      opts.emplace_back("--pch-storage=memory");
+      opts.emplace_back(fmt::format("-j={}", workers));
+      if (!option.database.empty()) {
+        opts.emplace_back(fmt::format("--compile-commands-dir={}", option.database));
+      }
+      return opts;
+    }
+
+    auto normalize(const std::string &path) -> std::string {
+      return std::filesystem::path{path}.lexically_normal().string();
+    }
+
+    auto to_serverity(int severity) -> std::string {
+      switch (severity) {
+      case 1 : return "error";
+      case 2 : return "warning";
+      default: return "info";
+      }
+    }
+
+    /// A minimal LSP client of clangd.
+    class clangd_client {
+    public:
+      clangd_client(const option_t &option, const runtime_context &context, std::size_t workers)
+        : process_(option.clangd_binary, make_clangd_options(option, workers), context.work_dir()) {
+      }
+
+      void initialize(const std::string &root_dir) {
+        auto capabilities = json{
+          {"general",      {{"positionEncodings", {"utf-8"}}}                      },
+          {"textDocument", {{"publishDiagnostics", {{"relatedInformation", false}}}}},
+          {"offsetEncoding", {"utf-8"}}
+        };
+        request("initialize",
+                {
+                  {"processId",    ::getpid()                 },
+                  {"rootUri",      lsp::path_to_uri(root_dir)},
+                  {"capabilities", capabilities               }
+        });
+        notify("initialized", json::object());
+      }
+
+      void open(const std::string &file_path, std::string text) {
+        auto language = file_path.ends_with(".c") ? "c" : "cpp";
+        notify("textDocument/didOpen",
+               {
+                 {"textDocument",
+                  {{"uri", lsp::path_to_uri(file_path)},
+                   {"languageId", language},
+                   {"version", 1},
+                   {"text", std::move(text)}}},
+                 {"wantDiagnostics", true}
+        });
+      }
+
+      void close(const std::string &file_path) {
+        notify("textDocument/didClose",
+               {
+                 {"textDocument", {{"uri", lsp::path_to_uri(file_path)}}}
+        });
+      }
+
+      // Block until the next diagnostics are published. Return the file path
+      // and its LSP diagnostics.
+      auto wait_diagnostics() -> std::pair<std::string, json> {
+        while (published_.empty()) {
+          handle(receive());
+        }
+        auto params = std::move(published_.front());
+        published_.pop_front();
+        return {lsp::uri_to_path(params.at("uri").get<std::string>()), params.at("diagnostics")};
+      }
+
+      void shutdown() {
+        request("shutdown", nullptr);
+        notify("exit", nullptr);
+        process_.wait();
+      }
+
+    private:
+      void send(const json &message) {
+        process_.write(lsp::encode(message));
+      }
+
+      void notify(std::string_view method, json params) {
+        send({
+          {"jsonrpc", "2.0"            },
+          {"method",  method           },
+          {"params",  std::move(params)}
+        });
+      }
+
+      auto request(std::string_view method, json params) -> json {
+        auto id = next_id_++;
+        send({
+          {"jsonrpc", "2.0"            },
+          {"id",      id               },
+          {"method",  method           },
+          {"params",  std::move(params)}
+        });
+        while (true) {
+          auto message = receive();
+          if (message.contains("id") && !message.contains("method") && message["id"] == id) {
+            throw_if(message.contains("error"), [&]() noexcept {
+              return fmt::format("clangd {} failed: {}", method, message["error"].dump());
+            });
+            return message.value("result", json{});
+          }
+          handle(message);
+        }
+      }
+
+      auto receive() -> json {
+        while (true) {
+          if (auto message = reader_.next()) {
+            return std::move(*message);
+          }
+          auto data = process_.read_some();
+          throw_if(data.empty(), "clangd exited unexpectedly");
+          reader_.feed(data);
+        }
+      }
+
+      void handle(const json &message) {
+        // Requests from clangd, such as creating a progress, are just accepted.
+        if (message.contains("id") && message.contains("method")) {
+          send({
+            {"jsonrpc", "2.0"        },
+            {"id",      message["id"]},
+            {"result",  nullptr      }
+          });
+          return;
+        }
+        if (message.value("method", std::string{}) == "textDocument/publishDiagnostics") {
+          published_.push_back(message.at("params"));
+        }
+      }
+
+      shell::interactive_process process_;
+      lsp::message_reader reader_;
+      std::deque<json> published_;
+      int next_id_ = 0;
+    };
+  } // namespace
+
+  // Compiler diagnostics are named as clang-diagnostic-* by clang-tidy.
+  auto to_diagnostic(const std::string &file_path, const json &lsp_diag) -> diagnostic {
+    const auto &start = lsp_diag.at("range").at("start");
+    auto source       = lsp_diag.value("source", std::string{});
+    auto code         = std::string{};
+    if (lsp_diag.contains("code")) {
+      code = lsp_diag["code"].is_string() ? lsp_diag["code"].get<std::string>()
+                                          : lsp_diag["code"].dump();
+    }
+
+    auto diag             = diagnostic{};
+    diag.header.file_name = file_path;
+    diag.header.row_idx   = std::to_string(start.at("line").get<int>() + 1);
+    diag.header.col_idx   = std::to_string(start.at("character").get<int>() + 1);
+    diag.header.serverity = to_serverity(lsp_diag.value("severity", 1));
+    diag.header.brief     = fmt::format(" {} ", lsp_diag.value("message", std::string{}));
+    if (source == "clang-tidy") {
+      diag.header.checks = code;
+    } else {
+      diag.header.checks = fmt::format("clang-diagnostic-{}",
+                                       code.empty() ? diag.header.serverity : code);
+    }
+    return diag;
+  }
+
+  auto clang_tidy_clangd::prepare(const runtime_context &context) -> std::size_t {
+    spdlog::trace("Enter clang_tidy_clangd::prepare()");
+    assert(!option.clangd_binary.empty() && "clangd binary is empty");
+    assert(!context.repo_path.empty() && "the repo_path of context is empty");
+
+    files        = collect_files(context, option, result);
+    file_results = std::vector<std::optional<per_file_result>>(files.size());
+    prepare_checkout(context);
+
+    // clangd builds files by its own threads, which are as many as the jobs
+    // it takes from the job graph.
+    auto limit     = max_jobs() == 0 ? context.jobs : std::min(max_jobs(), context.jobs);
+    workers_       = std::min(std::max<std::size_t>(limit, 1), files.size());
+    clangd_exited_ = std::promise<void>{};
+    clangd_exit_   = clangd_exited_.get_future().share();
+    return workers_;
+  }
+
+  auto clang_tidy_clangd::run_job(const runtime_context &context, std::size_t job) -> bool {
+    spdlog::trace("Enter clang_tidy_clangd::run_job()");
+    if (job != 0) {
+      clangd_exit_.wait();
+      return true;
+    }
+
+    auto passed = false;
+    try {
+      passed = check_by_clangd(context);
+    } catch (...) {
+      clangd_exited_.set_value();
+      throw;
+    }
+    clangd_exited_.set_value();
+    return passed;
+  }
+
+  auto clang_tidy_clangd::check_by_clangd(const runtime_context &context) -> bool {
+    spdlog::info("Running clangd: {}", option.clangd_binary);
+    auto client = clangd_client{run_option(context), context, workers_};
+    client.initialize(context.work_dir());
+
+    // Keep at most as many files opened as clangd workers, so that clangd
+    // builds them concurrently without holding the ASTs of all files.
+    auto window    = workers_;
+    auto next_file = std::size_t{0};
+    auto opened    = std::unordered_map<std::string, std::size_t>{};
+    auto open_next = [&] {
+      while (next_file < files.size() && opened.size() < window) {
+        auto path = normalize(fmt::format("{}/{}", context.work_dir(), files[next_file]));
+        client.open(path, std::string{context.snapshot(files[next_file]).content()});
+        opened[path] = next_file++;
+      }
+    };
+
+    auto passed = true;
+    open_next();
+    while (!opened.empty()) {
+      auto [uri_path, lsp_diags] = client.wait_diagnostics();
+      auto path                  = normalize(uri_path);
+      auto iter                  = opened.find(path);
+      if (iter == opened.end()) {
+        // Such as the empty diagnostics published after a file is closed.
+        continue;
+      }
+      auto index = iter->second;
+      opened.erase(iter);
+      client.close(path);
+
+      auto file_result        = per_file_result{};
+      file_result.file_path   = files[index];
+      file_result.file_option = make_file_option(files[index]);
+      for (const auto &lsp_diag: lsp_diags) {
+        file_result.diags.push_back(to_diagnostic(path, lsp_diag));
+      }
+      file_result.passed = ranges::none_of(file_result.diags, [](const auto &diag) {
+        return diag.header.serverity == "error";
+      });
+      passed              = passed && file_result.passed;
+      file_results[index] = std::move(file_result);
+
+      if (!passed && option.enabled_fastly_exit) {
+        spdlog::info("clang-tidy stops opening files since check failed");
+        next_file = files.size();
+      }
+      open_next();
+    }
+
+    client.shutdown();
+    return passed;
+  }
+
+} // namespace lint::tool::clang_tidy
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "tools/clang_tidy/general/impl.h"
+
+namespace lint::tool::clang_tidy {
+  /// The clang-tidy implementation which checks files by one long-lived clangd
+  /// with clang-tidy enabled. Files sharing headers reuse the preambles built
+  /// by clangd, so they're much cheaper than running clang-tidy on each file.
+  struct clang_tidy_clangd : clang_tidy_general {
+    explicit clang_tidy_clangd(option_t opt)
+      : clang_tidy_general(std::move(opt)) {
+    }
+
+    /// Return one job for each worker thread of clangd, so that the job graph
+    /// counts them against the shared jobs.
+    auto prepare(const runtime_context &context) -> std::size_t override;
+
+    /// All files are checked by the first job, since they share one clangd.
+    /// The other jobs hold their workers until clangd exits.
+    auto run_job(const runtime_context &context, std::size_t job) -> bool override;
+
+  private:
+    auto check_by_clangd(const runtime_context &context) -> bool;
+
+    std::size_t workers_ = 0;
+    std::promise<void> clangd_exited_;
+    std::shared_future<void> clangd_exit_;
+  };
+
+  /// Map an LSP diagnostic which clangd publishes for the file to the same
+  /// diagnostic printed by clang-tidy.
+  auto to_diagnostic(const std::string &file_path, const nlohmann::json &lsp_diag) -> diagnostic;
+
+} // namespace lint::tool::clang_tidy
@@ -16,6 +16,9 @@
 #include "tools/clang_tidy/general/impl.h"
 
 #include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <functional>
 #include <iterator>
 #include <optional>
 #include <string>
@@ -27,8 +30,11 @@
 #include <tinyxml2.h>
 
 #include "tools/clang_tidy/general/reporter.h"
+#include "tools/util.h"
 #include "utils/common.h"
+#include "utils/git_utils.h"
 #include "utils/shell.h"
+#include "utils/thread_pool.h"
 
 namespace lint::tool::clang_tidy {
   using namespace std::string_view_literals;
@@ -36,6 +42,9 @@ namespace lint::tool::clang_tidy {
   namespace {
     constexpr auto supported_serverity = {"warning"sv, "info"sv, "error"sv};
 
+    constexpr auto closure_cache_mode      = "closure"sv;
+    constexpr auto preprocessed_cache_mode = "preprocessed"sv;
+
     // Parse the header line of clang-tidy. If the given line meets header line
     // rule, parse it. Otherwise return std::nullopt.
     auto parse_diagnostic_header(std::string_view line) -> std::optional<diagnostic_header> {
@@ -82,10 +91,8 @@ namespace lint::tool::clang_tidy {
       return header;
     }
 
-    auto execute(const option_t &option, std::string_view repo, std::string_view file)
-      -> std::tuple<shell::result, std::string> {
-      spdlog::trace("Enter execute()");
-
+    // Make the options shared by all files.
+    auto make_options(const option_t &option) -> std::vector<std::string> {
       auto opts = std::vector<std::string>{};
       if (!option.database.empty()) {
         opts.emplace_back(fmt::format("-p={}", option.database));
@@ -111,15 +118,41 @@ namespace lint::tool::clang_tidy {
       if (!option.line_filter.empty()) {
         opts.emplace_back(fmt::format("--line-filter={}", option.line_filter));
       }
+      return opts;
+    }
 
-      opts.emplace_back(file);
+    // The directory of the compilation database in the workspace.
+    auto database_dir(const option_t &option, const runtime_context &context) -> std::string {
+      auto dir = std::filesystem::path{context.repo_path} / option.database;
+      return dir.lexically_normal().string();
+    }
+
+    // Return the path relative to the directory, or std::nullopt if it's out
+    // of the directory. Both are absolute.
+    auto relative_to(const std::string &path, const std::string &dir)
+      -> std::optional<std::string> {
+      auto relative = std::filesystem::path{path}.lexically_normal().lexically_relative(
+        std::filesystem::path{dir}.lexically_normal());
+      if (relative.empty() || *relative.begin() == "..") {
+        return std::nullopt;
+      }
+      return relative.generic_string();
+    }
 
-      auto arg_str = concat(opts, ' ');
-      spdlog::info("Running command: {} {}", option.binary, arg_str);
+    // Run one clang-tidy process for all given files.
+    auto execute(const shell::process_group &processes,
+                 const option_t &option,
+                 std::string_view repo,
+                 const std::vector<std::string> &files) -> shell::result {
+      spdlog::trace("Enter execute()");
 
-      return {shell::execute(option.binary, opts, repo), arg_str};
+      auto opts = make_options(option);
+      opts.insert(opts.end(), files.begin(), files.end());
+      spdlog::info("Running command: {} {}", option.binary, concat(opts, ' '));
+      return processes.execute(option.binary, opts, repo);
     }
 
+
     auto parse_stdout(std::string_view std_out) -> diagnostics {
       spdlog::trace("Enter parse_stdout()");
       auto diags         = diagnostics{};
@@ -228,65 +261,445 @@ namespace lint::tool::clang_tidy {
 
       return stat;
     }
+
+    // Return the size of the file in the workspace, or the size recorded in
+    // the diff delta if it couldn't be read.
+    auto file_size(const runtime_context &context, const std::string &file) -> std::uintmax_t {
+      auto ec   = std::error_code{};
+      auto size = std::filesystem::file_size(std::filesystem::path{context.work_dir()} / file, ec);
+      if (!ec) {
+        return size;
+      }
+      if (auto iter = context.deltas.find(file); iter != context.deltas.end()) {
+        return iter->second.new_file.size;
+      }
+      return 0;
+    }
+
+    // Order files by expected duration descendingly. Files checked before use
+    // their recorded durations. Others are estimated from their sizes by the
+    // average milliseconds per byte of known files.
+    auto order_by_expected_duration(const runtime_context &context,
+                                    const std::vector<std::string> &files,
+                                    const duration_history &history) -> std::vector<std::size_t> {
+      auto sizes       = std::vector<std::uintmax_t>(files.size());
+      auto durations   = std::vector<std::optional<std::uint64_t>>(files.size());
+      auto known_ms    = 0.0;
+      auto known_bytes = 0.0;
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        sizes[i]     = file_size(context, files[i]);
+        durations[i] = history.lookup(files[i]);
+        if (durations[i] && sizes[i] != 0) {
+          known_ms    += static_cast<double>(*durations[i]);
+          known_bytes += static_cast<double>(sizes[i]);
+        }
+      }
+      auto ms_per_byte = known_bytes == 0 ? 1.0 : known_ms / known_bytes;
+
+      auto expected = std::vector<double>(files.size());
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        expected[i] = durations[i] ? static_cast<double>(*durations[i])
+                                   : static_cast<double>(sizes[i]) * ms_per_byte;
+      }
+
+      auto order = ranges::views::iota(std::size_t{0}, files.size())
+                 | ranges::to<std::vector<std::size_t>>();
+      ranges::stable_sort(order, [&](auto lhs, auto rhs) { return expected[lhs] > expected[rhs]; });
+      return order;
+    }
+
+    // Split the stdout of clang-tidy into the text of each diagnostic, from
+    // its header line to the next one. They match diagnostics parsed by
+    // parse_stdout one by one.
+    auto split_diagnostics(std::string_view std_out) -> std::vector<std::string_view> {
+      auto texts = std::vector<std::string_view>{};
+      auto start = std::string_view::npos;
+      auto pos   = std::size_t{0};
+      while (pos < std_out.size()) {
+        auto end = std_out.find('\n', pos);
+        end      = end == std::string_view::npos ? std_out.size() : end;
+        if (parse_diagnostic_header(std_out.substr(pos, end - pos))) {
+          if (start != std::string_view::npos) {
+            texts.push_back(std_out.substr(start, pos - start));
+          }
+          start = pos;
+        }
+        pos = end + 1;
+      }
+      if (start != std::string_view::npos) {
+        texts.push_back(std_out.substr(start));
+      }
+      return texts;
+    }
+
+    // The diagnostics of a checked file and the text printed for them.
+    struct file_output {
+      diagnostics diags;
+      std::string text;
+    };
+
+    // Diagnostics routed to checked files, and those of other files.
+    struct routed_output {
+      std::vector<file_output> files;
+      diagnostics others;
+    };
+
+    // Route each diagnostic to the checked file it belongs to. clang-tidy
+    // prints file names as absolute paths, so they're compared with the files
+    // resolved against the root directory. Diagnostics of other files, such as
+    // headers, belong to the only file of a single file run. But clang-tidy
+    // sorts diagnostics of all files of a run and prints those of a shared
+    // header once, so they can't be attributed in a batch.
+    auto route_diagnostics(std::string_view std_out,
+                           const std::string &root_dir,
+                           const std::vector<std::string> &files) -> routed_output {
+      auto diags = parse_stdout(std_out);
+      auto texts = split_diagnostics(std_out);
+      assert(diags.size() == texts.size() && "diagnostics don't match their texts");
+
+      auto paths = std::vector<std::filesystem::path>{};
+      for (const auto &file: files) {
+        paths.push_back((std::filesystem::path{root_dir} / file).lexically_normal());
+      }
+      auto find_file = [&](const std::string &file_name) -> std::optional<std::size_t> {
+        if (files.size() == 1) {
+          return 0;
+        }
+        auto path = std::filesystem::path{file_name};
+        if (!path.is_absolute()) {
+          path = std::filesystem::path{root_dir} / path;
+        }
+        path = path.lexically_normal();
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+          if (paths[i] == path) {
+            return i;
+          }
+        }
+        return std::nullopt;
+      };
+
+      auto routed = routed_output{.files = std::vector<file_output>(files.size()), .others = {}};
+      for (std::size_t i = 0; i < diags.size(); ++i) {
+        auto index = find_file(diags[i].header.file_name);
+        if (!index) {
+          spdlog::debug("diagnostic of {} isn't of any checked file", diags[i].header.file_name);
+          routed.others.push_back(std::move(diags[i]));
+          continue;
+        }
+        routed.files[*index].diags.push_back(std::move(diags[i]));
+        routed.files[*index].text += texts[i];
+      }
+      return routed;
+    }
+
+    // Return lines of the stderr of a batch which mention the file, such as
+    // "Error while processing <file>.".
+    auto lines_of_file(std::string_view std_err, const std::string &file) -> std::string {
+      auto lines = std::string{};
+      for (auto part: std::views::split(std_err, '\n')) {
+        auto line = ranges::to<std::string>(part);
+        if (line.find(file) != std::string::npos) {
+          lines += line;
+          lines += '\n';
+        }
+      }
+      return lines;
+    }
+
+    auto has_error(const diagnostics &diags) -> bool {
+      return ranges::any_of(diags,
+                            [](const auto &diag) { return diag.header.serverity == "error"; });
+    }
   } // namespace
 
-  auto clang_tidy_general::check_single_file(
-    [[maybe_unused]] const runtime_context &context,
-    const std::string &root_dir,
-    const std::string &file) const -> per_file_result {
+  auto clang_tidy_general::check_single_file(const runtime_context &context,
+                                             const std::string &root_dir,
+                                             const std::string &file) const -> per_file_result {
     spdlog::trace("Enter clang_tidy_general::check_single_file()");
+    return std::move(check_files(context, root_dir, {file}).front());
+  }
+
+  auto clang_tidy_general::check_files(const runtime_context &context,
+                                       const std::string &root_dir,
+                                       const std::vector<std::string> &files) const
+    -> std::vector<per_file_result> {
+    spdlog::trace("Enter clang_tidy_general::check_files()");
+
+    auto res    = execute(processes, run_option(context), root_dir, files);
+    auto routed = route_diagnostics(res.std_out, root_dir, files);
+
+    // The exit code belongs to the whole process. If it fails, files with
+    // error diagnostics fail. If no file has any, the failure can't be
+    // attributed to a file, so all of them fail.
+    auto attributable = ranges::any_of(routed.files, [](const auto &output) {
+      return has_error(output.diags);
+    });
+
+    auto results = std::vector<per_file_result>(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      auto &output       = routed.files[i];
+      auto &result       = results[i];
+      auto path          = (std::filesystem::path{root_dir} / files[i]).lexically_normal().string();
+      result.passed      = res.exit_code == 0 || (attributable && !has_error(output.diags));
+      result.diags       = std::move(output.diags);
+      result.tool_stdout = std::move(output.text);
+      result.tool_stderr = files.size() == 1 ? res.std_err : lines_of_file(res.std_err, path);
+      result.file_path   = files[i];
+      result.file_option = make_file_option(files[i]);
+    }
 
-    auto [res, failed_command] = execute(option, root_dir, file);
+    // Warnings of other files are dropped. A header filter option disables
+    // batches, so they're only selected by HeaderFilterRegex of config files
+    // here. But an error of another file, such as a broken header, may belong
+    // to any file without errors of its own, so only those files are checked
+    // again one by one.
+    if (has_error(routed.others)) {
+      for (auto &result: results) {
+        if (!has_error(result.diags)) {
+          spdlog::debug("check {} again since the batch has errors of other files",
+                        result.file_path);
+          result = check_single_file(context, root_dir, result.file_path);
+        }
+      }
+    }
+    return results;
+  }
 
-    auto result        = per_file_result{};
-    result.passed      = res.exit_code == 0;
-    result.diags       = parse_stdout(res.std_out);
-    result.tool_stdout = res.std_out;
-    result.tool_stderr = res.std_err;
-    result.file_path   = file;
-    result.file_option = failed_command;
-    return result;
+  auto clang_tidy_general::make_file_option(const std::string &file) const -> std::string {
+    auto opts = make_options(option);
+    opts.emplace_back(file);
+    return concat(opts, ' ');
   }
 
-  void clang_tidy_general::check(const runtime_context &context) {
-    spdlog::trace("Enter clang_tidy_general::check");
-    assert(!option.binary.empty() && "clang-tidy binary is empty");
-    assert(!context.repo_path.empty() && "the repo_path of context is empty");
+  auto clang_tidy_general::run_option(const runtime_context &context) const -> option_t {
+    if (context.checkout_dir.empty()) {
+      return option;
+    }
+    auto opt = option;
+    if (!opt.database.empty()) {
+      opt.database = relocated ? context.checkout_dir : database_dir(option, context);
+    }
+    if (!opt.config_file.empty()) {
+      opt.config_file = (std::filesystem::path{context.repo_path} / opt.config_file).string();
+    }
+    return opt;
+  }
 
-    const auto root_dir = context.repo_path;
-    const auto files    = context.changed_files;
+  void clang_tidy_general::prepare_checkout(const runtime_context &context) {
+    relocated = false;
+    if (context.checkout_dir.empty() || option.database.empty()) {
+      return;
+    }
+    auto build_dir = database_dir(option, context);
+    auto workspace = cache::compile_database::load(build_dir);
+    if (!workspace) {
+      spdlog::warn("No compilation database is found in {}, so files are checked without compile "
+                   "commands",
+                   build_dir);
+      return;
+    }
+
+    // Headers in the build directory are build artifacts, which are still
+    // found in the workspace.
     for (const auto &file: files) {
-      const auto &delta = context.deltas.at(file);
-      if (delta.status == GIT_DELTA_DELETED) {
+      const auto *command = workspace->find(fmt::format("{}/{}", context.repo_path, file));
+      if (command == nullptr) {
         continue;
       }
-      if (filter_file(option.file_filter_iregex, file)) {
-        result.ignored.push_back(file);
-        spdlog::debug("file {} is ignored by {}", file, option.binary);
-        continue;
+      auto dirs = std::vector<std::string>{};
+      for (const auto &dir: cache::include_dirs(*command)) {
+        auto relative = relative_to(dir, context.repo_path);
+        if (relative && !relative_to(dir, build_dir)) {
+          dirs.push_back(std::move(*relative));
+        }
       }
+      write_revision_files(context, {file}, dirs);
+    }
+    workspace->relocate(context.repo_path, context.checkout_dir, build_dir)
+      .save(context.checkout_dir);
+    relocated = true;
+  }
 
-      auto per_file_result = check_single_file(context, root_dir, file);
-      if (per_file_result.passed) {
-        spdlog::info("file: {} passes {} check.", file, option.binary);
-        result.passes[file] = std::move(per_file_result);
-        continue;
+  auto clang_tidy_general::find_command(const runtime_context &context,
+                                        const std::string &file) const
+    -> std::optional<cache::compile_command> {
+    const auto *command =
+      database ? database->find(fmt::format("{}/{}", context.repo_path, file)) : nullptr;
+    if (command == nullptr) {
+      return std::nullopt;
+    }
+    if (context.checkout_dir.empty()) {
+      return *command;
+    }
+    return cache::relocate(*command,
+                           context.repo_path,
+                           context.checkout_dir,
+                           database_dir(option, context));
+  }
+
+  auto clang_tidy_general::cache_key(const runtime_context &context,
+                                     const std::string &file) const
+    -> std::optional<std::string> {
+    const auto &id = context.snapshot(file).id();
+    const auto *command =
+      database ? database->find(fmt::format("{}/{}", context.repo_path, file)) : nullptr;
+    if (git::oid::is_zero(id) || command == nullptr) {
+      return std::nullopt;
+    }
+
+    auto builder = cache::key_builder{};
+    builder.add("clang-tidy").add(option.version).add(option.binary).add(make_file_option(file));
+    builder.add(file).add(id).add(command->directory);
+    for (const auto &argument: command->arguments) {
+      builder.add(argument);
+    }
+    for (const auto &config: cache::config_chain(context.work_dir(), file, {".clang-tidy"})) {
+      builder.add(config);
+    }
+    if (!option.config_file.empty()) {
+      builder.add(hasher->hash(
+        (std::filesystem::path{context.repo_path} / option.config_file).string()));
+    }
+
+    // The preprocessed source with comments covers all included files,
+    // macros and NOLINT comments, so the result needs no further validation.
+    if (option.cache_mode == preprocessed_cache_mode) {
+      auto preprocessed =
+        cache::hash_preprocessed(*find_command(context, file), context.work_dir());
+      if (!preprocessed) {
+        return std::nullopt;
       }
+      builder.add(*preprocessed);
+    }
+    return builder.build();
+  }
+
+  void clang_tidy_general::store_result(const runtime_context &context,
+                                        const std::string &key,
+                                        const per_file_result &file_result) const {
+    // A failure without any diagnostic may be a crash of clang-tidy, which
+    // shouldn't be replayed by later runs.
+    if (!file_result.passed && file_result.diags.empty()) {
+      return;
+    }
+    if (option.cache_mode == preprocessed_cache_mode) {
+      cache->put(key, file_result);
+      return;
+    }
 
-      spdlog::error("file: {} doesn't pass {} check.", file, option.binary);
-      result.failed_commands.emplace_back(
-        fmt::format("clang-tidy {}", per_file_result.file_option));
-      result.fails[file] = std::move(per_file_result);
+    auto command = find_command(context, file_result.file_path);
+    auto closure = cache::scan_include_closure(*command, *hasher, context.work_dir());
+    if (!closure) {
+      return;
+    }
+    auto value        = nlohmann::json(file_result);
+    value["includes"] = std::move(*closure);
+    cache->put(key, value);
+  }
 
-      if (option.enabled_fastly_exit) {
-        spdlog::info("{} fastly exit since check failed", option.binary);
-        result.final_passed  = false;
-        result.fastly_exited = true;
-        return;
+  auto clang_tidy_general::prepare(const runtime_context &context) -> std::size_t {
+    spdlog::trace("Enter clang_tidy_general::prepare()");
+    assert(!option.binary.empty() && "clang-tidy binary is empty");
+    assert(!context.repo_path.empty() && "the repo_path of context is empty");
+    assert(option.batch_size != 0 && "the batch size of clang-tidy is 0");
+
+    files        = collect_files(context, option, result);
+    file_results = std::vector<std::optional<per_file_result>>(files.size());
+    cache_keys   = std::vector<std::optional<std::string>>(files.size());
+    prepare_checkout(context);
+
+    auto pending = ranges::views::iota(std::size_t{0}, files.size())
+                 | ranges::to<std::vector<std::size_t>>();
+    cache        = open_result_cache(context, "clang-tidy");
+    if (cache) {
+      hasher   = std::make_unique<cache::file_hasher>();
+      database = cache::compile_database::load(database_dir(option, context));
+      if (database) {
+        // Keys may need to preprocess files, so they're made concurrently.
+        auto pool = thread_pool{std::min(context.jobs, files.size())};
+        for (std::size_t i = 0; i < files.size(); ++i) {
+          pool.submit([&, i] { cache_keys[i] = cache_key(context, files[i]); });
+        }
+        pool.wait();
+
+        // In closure mode, a result is only valid if no included file changes.
+        auto is_valid = std::function<bool(const nlohmann::json &)>{};
+        if (option.cache_mode == closure_cache_mode) {
+          is_valid = [&](const nlohmann::json &value) {
+            return value.contains("includes")
+                && cache::is_unchanged(value.at("includes").get<cache::include_closure>(),
+                                       *hasher,
+                                       context.work_dir());
+          };
+        }
+        pending = lookup_cached_results(*cache, cache_keys, file_results, result, is_valid);
+      } else {
+        spdlog::debug("clang-tidy results aren't cached since no compilation database is found");
       }
     }
 
-    result.final_passed = result.fails.empty();
+    auto store = context.cache_dir.empty() ? std::string{}
+                                           : fmt::format("{}/durations.json", context.cache_dir);
+    history    = std::make_unique<duration_history>(store, fmt::format("clang-tidy-{}", version()));
+
+    auto pending_files = pending
+                       | ranges::views::transform([&](auto index) { return files[index]; })
+                       | ranges::to<std::vector<std::string>>();
+    // Diagnostics of headers selected by a header filter can't be attributed
+    // to files of a batch, so each file is checked by its own process then.
+    auto batch_size = option.header_filter.empty() ? option.batch_size : std::size_t{1};
+    if (batch_size != option.batch_size) {
+      spdlog::info("clang-tidy checks files one by one since a header filter is set");
+    }
+    batches.clear();
+    for (auto index: order_by_expected_duration(context, pending_files, *history)) {
+      if (batches.empty() || batches.back().size() == batch_size) {
+        batches.emplace_back();
+      }
+      batches.back().push_back(pending[index]);
+    }
+    return batches.size();
+  }
+
+  auto clang_tidy_general::run_job(const runtime_context &context, std::size_t job) -> bool {
+    const auto &batch = batches[job];
+    auto batch_files  = batch
+                     | ranges::views::transform([&](auto index) { return files[index]; })
+                     | ranges::to<std::vector<std::string>>();
+
+    auto start   = std::chrono::steady_clock::now();
+    auto results = check_files(context, context.work_dir(), batch_files);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (processes.killed()) {
+      // Results and durations of killed runs are incomplete, so they're
+      // neither recorded nor reported.
+      return true;
+    }
+
+    // The duration of a batch is shared evenly by its files.
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    auto passed       = true;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      auto index = batch[i];
+      history->record(files[index], milliseconds / batch.size());
+      passed = passed && results[i].passed;
+      if (cache_keys[index]) {
+        store_result(context, *cache_keys[index], results[i]);
+      }
+      file_results[index] = std::move(results[i]);
+    }
+    return passed;
+  }
+
+  void clang_tidy_general::cancel() {
+    processes.kill();
+  }
+
+  void clang_tidy_general::finish([[maybe_unused]] const runtime_context &context) {
+    merge_results(result, file_results, option.enabled_fastly_exit, "clang-tidy", option.binary);
+    if (history) {
+      history->save();
+    }
   }
 
   auto clang_tidy_general::get_reporter() -> reporter_base_ptr {
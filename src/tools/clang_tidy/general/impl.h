@@ -15,14 +15,21 @@
  */
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include "cache/include_closure.h"
+#include "cache/result_cache.h"
 #include "tools/base_tool.h"
 #include "tools/clang_tidy/general/option.h"
 #include "tools/clang_tidy/general/result.h"
+#include "utils/duration_history.h"
+#include "utils/shell.h"
 
 namespace lint::tool::clang_tidy {
   /// The general implementation of clang-tidy.
@@ -51,12 +58,87 @@ namespace lint::tool::clang_tidy {
                            const std::string &root_dir,
                            const std::string &file) const -> per_file_result;
 
-    void check(const runtime_context &context) override;
+    /// Check all given files by one clang-tidy process. Diagnostics are
+    /// routed back to the file they belong to.
+    auto check_files(const runtime_context &context,
+                     const std::string &root_dir,
+                     const std::vector<std::string> &files) const -> std::vector<per_file_result>;
+
+    /// Make the options of the command which reproduces the check of a file.
+    auto make_file_option(const std::string &file) const -> std::string;
+
+    /// Return the option to run with in the context. If files are checked in
+    /// the checkout directory, paths given by users are resolved against the
+    /// workspace and the compilation database is the relocated one.
+    auto run_option(const runtime_context &context) const -> option_t;
+
+    /// If files are checked in the checkout directory, write the compilation
+    /// database relocated there, together with headers of the source revision
+    /// found from the include directories of files to be checked.
+    void prepare_checkout(const runtime_context &context);
+
+    /// Return the compile command of the file as it's run, or std::nullopt if
+    /// there isn't one.
+    auto find_command(const runtime_context &context, const std::string &file) const
+      -> std::optional<cache::compile_command>;
+
+    /// Return the result cache key of the file, or std::nullopt if the file
+    /// content isn't known by git or the file has no compile command. The key
+    /// doesn't cover included headers, which are validated by the include
+    /// closure stored along with the result.
+    auto cache_key(const runtime_context &context, const std::string &file) const
+      -> std::optional<std::string>;
+
+    /// Store the result of a checked file along with its include closure.
+    void store_result(const runtime_context &context,
+                      const std::string &key,
+                      const per_file_result &file_result) const;
+
+    auto prepare(const runtime_context &context) -> std::size_t override;
+
+    auto run_job(const runtime_context &context, std::size_t job) -> bool override;
+
+    void finish(const runtime_context &context) override;
+
+    auto max_jobs() -> std::size_t override {
+      return option.max_jobs;
+    }
+
+    auto fastly_exit() -> bool override {
+      return option.enabled_fastly_exit;
+    }
+
+    void cancel() override;
 
     auto get_reporter() -> reporter_base_ptr override;
 
     option_t option;
     result_t result;
+
+    // Files to be checked and their results, in the order of changed files.
+    std::vector<std::string> files;
+    std::vector<std::optional<per_file_result>> file_results;
+
+    // Each job checks a batch of files by one clang-tidy process. Batches are
+    // made of file indexes ordered by expected duration descendingly, so that
+    // the slowest files don't become the tail.
+    std::vector<std::vector<std::size_t>> batches;
+    std::unique_ptr<duration_history> history;
+
+    // Files served by the result cache aren't batched. Results are only
+    // cached if the compilation database is found, since it's needed to scan
+    // included headers.
+    std::vector<std::optional<std::string>> cache_keys;
+    std::unique_ptr<cache::result_cache> cache;
+    std::optional<cache::compile_database> database;
+    std::unique_ptr<cache::file_hasher> hasher;
+
+    // Whether the compilation database is relocated into the checkout
+    // directory.
+    bool relocated = false;
+
+    // All clang-tidy processes, which are killed together on fastly exit.
+    shell::process_group processes;
   };
 
 } // namespace lint::tool::clang_tidy
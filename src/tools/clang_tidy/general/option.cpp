@@ -26,6 +26,8 @@ namespace lint::tool::clang_tidy {
     spdlog::debug("version: {}", option.version);
     spdlog::debug("binary: {}", option.binary);
     spdlog::debug("file-filter-iregex: {}", option.file_filter_iregex);
+    spdlog::debug("max-jobs: {}", option.max_jobs);
+    spdlog::debug("batch-size: {}", option.batch_size);
     spdlog::debug("allow-no-checks: {}", option.allow_no_checks);
     spdlog::debug("enable-check-profile: {}", option.enable_check_profile);
     spdlog::debug("checks: {}", option.checks);
@@ -34,6 +36,9 @@ namespace lint::tool::clang_tidy {
     spdlog::debug("database: {}", option.database);
     spdlog::debug("header-filter: {}", option.header_filter);
     spdlog::debug("line-filter: {}", option.line_filter);
+    spdlog::debug("engine: {}", option.engine);
+    spdlog::debug("clangd-binary: {}", option.clangd_binary);
+    spdlog::debug("cache-mode: {}", option.cache_mode);
     spdlog::debug("");
   }
 
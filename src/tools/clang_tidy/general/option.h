@@ -21,12 +21,16 @@ namespace lint::tool::clang_tidy {
   struct option_t : option_base {
     bool allow_no_checks      = false;
     bool enable_check_profile = false;
+    std::size_t batch_size    = 1;
     std::string checks;
     std::string config;
     std::string config_file;
     std::string database;
     std::string header_filter;
     std::string line_filter;
+    std::string engine = "process";
+    std::string clangd_binary;
+    std::string cache_mode = "closure";
   };
 
   void print_option(const option_t& option);
@@ -71,6 +71,10 @@ namespace lint::tool::clang_tidy {
               result.ignored.size()};
     }
 
+    auto get_cache_stats() -> std::tuple<std::size_t, std::size_t> override {
+      return {result.cache_hits, result.cache_misses};
+    }
+
     auto get_detail_result([[maybe_unused]] const runtime_context &context)
       -> std::string override {
       spdlog::trace("Enter clang_tidy::reporter_t::get_detail_result()");
@@ -103,28 +107,20 @@ namespace lint::tool::clang_tidy {
         assert(per_file_result.file_path == file);
         assert(context.patches.contains(file));
 
-        const auto &patch   = context.patches.at(file);
-        const auto num_hunk = git::patch::num_hunks(*patch);
+        const auto &hunks = context.snapshot(file).hunks(context.patches);
 
-        // For each clang-tidy diagnostic result in current file:
+        // For each clang-tidy diagnostic result in current file, comment on
+        // it only if it's in a diff hunk.
         for (const auto &diag: per_file_result.diags) {
-          auto row = std::stoi(diag.header.row_idx);
-          auto col = std::stoi(diag.header.col_idx);
-
-          // Check current diagnostic is in diff hunk.
-          auto pos = std::size_t{0};
-          for (int hunk_idx = 0; hunk_idx < num_hunk; ++hunk_idx) {
-            auto [hunk, num_lines] = git::patch::get_hunk(*patch, hunk_idx);
-            if (!git::hunk::is_row_in_hunk(hunk, row)) {
-              pos += num_lines;
-            } else {
-              auto comment     = github::review_comment{};
-              comment.path     = file;
-              comment.position = pos + row - hunk.new_start + 1;
-              comment.body     = diag.header.brief + diag.header.checks;
-              comments.emplace_back(std::move(comment));
-            }
+          auto position = hunks.position(std::stoi(diag.header.row_idx));
+          if (!position) {
+            continue;
           }
+          auto comment     = github::review_comment{};
+          comment.path     = file;
+          comment.position = *position;
+          comment.body     = diag.header.brief + diag.header.checks;
+          comments.emplace_back(std::move(comment));
         }
       }
       return comments;
@@ -17,6 +17,8 @@
 
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 #include "tools/base_result.h"
 
 namespace lint::tool::clang_tidy {
@@ -57,5 +59,28 @@ namespace lint::tool::clang_tidy {
     diagnostics diags;
   };
 
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(statistic,
+                                     warnings,
+                                     errors,
+                                     warnings_treated_as_errors,
+                                     total_suppressed_warnings,
+                                     non_user_code_warnings,
+                                     no_lint_warnings)
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    diagnostic_header, file_name, row_idx, col_idx, serverity, brief, checks)
+  NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(diagnostic, header, details)
+
+  inline void to_json(nlohmann::json &json, const per_file_result &result) {
+    to_json(json, static_cast<const per_file_result_base &>(result));
+    json["stat"]  = result.stat;
+    json["diags"] = result.diags;
+  }
+
+  inline void from_json(const nlohmann::json &json, per_file_result &result) {
+    from_json(json, static_cast<per_file_result_base &>(result));
+    json.at("stat").get_to(result.stat);
+    json.at("diags").get_to(result.diags);
+  }
+
   using result_t = multi_files_result_base<per_file_result>;
 } // namespace lint::tool::clang_tidy
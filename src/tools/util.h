@@ -15,9 +15,21 @@
  */
 #pragma once
 
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "cache/pack_backend.h"
+#include "cache/result_cache.h"
+#include "context.h"
+#include "tools/base_option.h"
+#include "tools/base_result.h"
 #include "utils/common.h"
 #include "utils/error.h"
 #include "utils/shell.h"
@@ -32,4 +44,183 @@ namespace lint::tool {
     throw_if(trimmed.empty(), "got empty clang tool path");
     return {trimmed.data(), trimmed.size()};
   }
+
+  /// Collect the changed files which should be checked by a tool. Deleted
+  /// files are skipped and files filtered out by the tool's file filter are
+  /// recorded as ignored.
+  template <class PerFileResult>
+  auto collect_files(const runtime_context &context,
+                     const option_base &option,
+                     multi_files_result_base<PerFileResult> &result) -> std::vector<std::string> {
+    auto files = std::vector<std::string>{};
+    for (const auto &file: context.changed_files) {
+      const auto &delta = context.deltas.at(file);
+      if (delta.status == GIT_DELTA_DELETED) {
+        continue;
+      }
+      if (filter_file(option.file_filter_iregex, file)) {
+        result.ignored.push_back(file);
+        spdlog::debug("file {} is ignored by {}", file, option.binary);
+        continue;
+      }
+      files.push_back(file);
+    }
+    return files;
+  }
+
+  /// Open the result cache of a tool configured by the context, or return
+  /// nullptr if it's disabled. The local pack is searched before the remote
+  /// server. Each tool has its own pack, since a pack is locked by its user.
+  inline auto open_result_cache(const runtime_context &context, std::string_view tool_name)
+    -> std::unique_ptr<cache::result_cache> {
+    if (!context.enable_result_cache) {
+      return nullptr;
+    }
+    auto backends = std::vector<cache::backend_base_ptr>{};
+    if (!context.cache_dir.empty()) {
+      backends.push_back(std::make_unique<cache::pack_backend>(
+        fmt::format("{}/results/{}", context.cache_dir, tool_name), context.result_cache_max_size));
+    }
+    if (!context.result_cache_url.empty()) {
+      backends.push_back(std::make_unique<cache::http_backend>(context.result_cache_url,
+                                                               context.result_cache_token));
+    }
+    if (backends.empty()) {
+      return nullptr;
+    }
+    return std::make_unique<cache::result_cache>(std::move(backends));
+  }
+
+  /// Serve files from the result cache. Cached results are filled into
+  /// `per_file_results` and indexes of the remaining files are returned. Files
+  /// without a key are never cached. If `is_valid` is given, cached values
+  /// rejected by it, or which it throws on, are treated as misses.
+  template <class PerFileResult>
+  auto lookup_cached_results(const cache::result_cache &cache,
+                             const std::vector<std::optional<std::string>> &keys,
+                             std::vector<std::optional<PerFileResult>> &per_file_results,
+                             multi_files_result_base<PerFileResult> &result,
+                             const std::function<bool(const nlohmann::json &)> &is_valid = {})
+    -> std::vector<std::size_t> {
+    auto pending = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      auto cached = keys[i] ? cache.get(*keys[i]) : std::nullopt;
+      if (cached) {
+        // Validation reads fields of the cached value too, so a broken value
+        // may throw from it.
+        try {
+          if (is_valid && !is_valid(*cached)) {
+            spdlog::debug("drop stale cached result {}", *keys[i]);
+          } else {
+            per_file_results[i] = cached->template get<PerFileResult>();
+            ++result.cache_hits;
+            spdlog::debug("result of file {} is served by cache", per_file_results[i]->file_path);
+            continue;
+          }
+        } catch (const std::exception &err) {
+          spdlog::debug("drop broken cached result {}: {}", *keys[i], err.what());
+        }
+      }
+      ++result.cache_misses;
+      pending.push_back(i);
+    }
+    return pending;
+  }
+
+  /// Return the old path of a file which is moved to another directory without
+  /// any change, or std::nullopt. The file name is kept, since tools may treat
+  /// files differently by their names, such as the main include of a source.
+  inline auto moved_from(const runtime_context &context, const std::string &file)
+    -> std::optional<std::string> {
+    auto iter = context.renames.find(file);
+    if (iter == context.renames.end()) {
+      return std::nullopt;
+    }
+    const auto &delta = context.deltas.at(file);
+    if (!git::oid::equal(delta.old_file.id, delta.new_file.id)) {
+      return std::nullopt;
+    }
+    auto old_path = std::filesystem::path{iter->second};
+    if (old_path.filename() != std::filesystem::path{file}.filename()) {
+      return std::nullopt;
+    }
+    return old_path.string();
+  }
+
+  /// Serve pending files which are moved without changes from results cached
+  /// under their old paths. `old_keys` holds keys made with the old paths. A
+  /// served result is moved to the new path by `relocate` and also stored under
+  /// the new key, so later runs hit it directly. Indexes of the remaining files
+  /// are returned.
+  template <class PerFileResult>
+  auto lookup_moved_results(const cache::result_cache &cache,
+                            const std::vector<std::size_t> &pending,
+                            const std::vector<std::optional<std::string>> &keys,
+                            const std::vector<std::optional<std::string>> &old_keys,
+                            std::vector<std::optional<PerFileResult>> &per_file_results,
+                            multi_files_result_base<PerFileResult> &result,
+                            const std::function<void(PerFileResult &, std::size_t)> &relocate)
+    -> std::vector<std::size_t> {
+    auto remaining = std::vector<std::size_t>{};
+    for (auto index: pending) {
+      auto cached = old_keys[index] ? cache.get(*old_keys[index]) : std::nullopt;
+      if (!cached) {
+        remaining.push_back(index);
+        continue;
+      }
+      try {
+        auto moved = cached->template get<PerFileResult>();
+        auto from  = moved.file_path;
+        relocate(moved, index);
+        if (keys[index]) {
+          cache.put(*keys[index], moved);
+        }
+        spdlog::debug("result of file {} is served by cache of {}", moved.file_path, from);
+        per_file_results[index] = std::move(moved);
+        --result.cache_misses;
+        ++result.cache_hits;
+      } catch (const std::exception &err) {
+        spdlog::debug("drop broken cached result {}: {}", *old_keys[index], err.what());
+        remaining.push_back(index);
+      }
+    }
+    return remaining;
+  }
+
+  /// Merge the ordered per-file results into `result`. The merge stops at the
+  /// first failed file if `fastly_exit` is set, so the final result is the same
+  /// as checking files one by one.
+  template <class PerFileResult>
+  void merge_results(multi_files_result_base<PerFileResult> &result,
+                     std::vector<std::optional<PerFileResult>> &per_file_results,
+                     bool fastly_exit,
+                     std::string_view tool_name,
+                     std::string_view binary) {
+    for (auto &per_file_result: per_file_results) {
+      if (!per_file_result) {
+        // Cancelled by fastly exit.
+        continue;
+      }
+      auto file = per_file_result->file_path;
+      if (per_file_result->passed) {
+        spdlog::info("file: {} passes {} check.", file, binary);
+        result.passes[file] = std::move(*per_file_result);
+        continue;
+      }
+
+      spdlog::error("file: {} doesn't pass {} check.", file, binary);
+      result.failed_commands.emplace_back(
+        fmt::format("{} {}", tool_name, per_file_result->file_option));
+      result.fails[file] = std::move(*per_file_result);
+
+      if (fastly_exit) {
+        spdlog::info("{} fastly exit since check failed", binary);
+        result.final_passed  = false;
+        result.fastly_exited = true;
+        return;
+      }
+    }
+
+    result.final_passed = result.fails.empty();
+  }
 } // namespace lint::tool
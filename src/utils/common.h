@@ -15,7 +15,9 @@
  */
 #pragma once
 
+#include <functional>
 #include <string_view>
+#include <utility>
 
 #include <boost/regex.hpp>
 #include <range/v3/algorithm/contains.hpp>
@@ -68,5 +70,26 @@ namespace lint {
     }
   }
 
+  /// Call the function when leaving the scope, even by an exception.
+  class scope_guard {
+  public:
+    explicit scope_guard(std::function<void()> f)
+      : func_(std::move(f)) {
+    }
+
+    ~scope_guard() {
+      if (func_) {
+        func_();
+      }
+    }
+
+    scope_guard(const scope_guard &)            = delete;
+    scope_guard &operator=(const scope_guard &) = delete;
+    scope_guard(scope_guard &&)                 = delete;
+    scope_guard &operator=(scope_guard &&)      = delete;
+
+  private:
+    std::function<void()> func_;
+  };
 
 } // namespace lint
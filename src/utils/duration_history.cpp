@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/duration_history.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <utility>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+namespace lint {
+  namespace {
+    auto read_store(const std::string &store_file) -> nlohmann::json {
+      auto file = std::ifstream{store_file};
+      if (!file.is_open()) {
+        return nlohmann::json::object();
+      }
+      auto store = nlohmann::json::parse(file, nullptr, false);
+      if (store.is_discarded() || !store.is_object()) {
+        spdlog::debug("ignore broken duration history {}", store_file);
+        return nlohmann::json::object();
+      }
+      return store;
+    }
+
+    auto days_since_epoch() -> std::int64_t {
+      auto now = std::chrono::system_clock::now().time_since_epoch();
+      return std::chrono::duration_cast<std::chrono::days>(now).count();
+    }
+
+    // An entry is {"ms": duration, "seen": day}. A plain duration is written
+    // by older versions, and it's taken as seen today.
+    auto parse_entry(const nlohmann::json &value, std::int64_t today)
+      -> std::optional<std::pair<std::uint64_t, std::int64_t>> {
+      if (value.is_number_unsigned()) {
+        return std::pair{value.get<std::uint64_t>(), today};
+      }
+      if (value.is_object() && value.contains("ms") && value["ms"].is_number_unsigned()
+          && value.contains("seen") && value["seen"].is_number_integer()) {
+        return std::pair{value["ms"].get<std::uint64_t>(), value["seen"].get<std::int64_t>()};
+      }
+      return std::nullopt;
+    }
+  } // namespace
+
+  duration_history::duration_history(std::string store_file, std::string key)
+    : store_file_(std::move(store_file))
+    , key_(std::move(key))
+    , today_(days_since_epoch()) {
+    if (store_file_.empty()) {
+      return;
+    }
+    auto store = read_store(store_file_);
+    if (!store.contains(key_) || !store[key_].is_object()) {
+      return;
+    }
+    for (const auto &[file, value]: store[key_].items()) {
+      if (auto parsed = parse_entry(value, today_)) {
+        durations_[file] = entry{.milliseconds = parsed->first, .seen = parsed->second};
+      }
+    }
+    spdlog::debug("loaded {} durations of {} from {}", durations_.size(), key_, store_file_);
+  }
+
+  auto duration_history::lookup(const std::string &file) const -> std::optional<std::uint64_t> {
+    auto lock = std::lock_guard{mutex_};
+    if (auto iter = durations_.find(file); iter != durations_.end()) {
+      return iter->second.milliseconds;
+    }
+    return std::nullopt;
+  }
+
+  void duration_history::record(const std::string &file, std::uint64_t milliseconds) {
+    auto lock = std::lock_guard{mutex_};
+    if (auto iter = durations_.find(file); iter != durations_.end()) {
+      // Smooth the duration to avoid a noisy run reordering all files.
+      iter->second.milliseconds = (iter->second.milliseconds + milliseconds) / 2;
+      iter->second.seen         = today_;
+      return;
+    }
+    durations_[file] = entry{.milliseconds = milliseconds, .seen = today_};
+  }
+
+  void duration_history::save() const {
+    if (store_file_.empty()) {
+      return;
+    }
+    auto lock  = std::lock_guard{mutex_};
+    auto store = read_store(store_file_);
+
+    // Entries saved by concurrent runners are merged. A value of the key which
+    // isn't an object is treated as empty.
+    auto merged  = nlohmann::json::object();
+    auto is_seen = [&](std::int64_t seen) { return today_ - seen <= max_unseen_days; };
+    if (store.contains(key_) && store[key_].is_object()) {
+      for (const auto &[file, value]: store[key_].items()) {
+        if (auto parsed = parse_entry(value, today_); parsed && is_seen(parsed->second)) {
+          merged[file] = {
+            {"ms",   parsed->first },
+            {"seen", parsed->second}
+          };
+        }
+      }
+    }
+    for (const auto &[file, duration]: durations_) {
+      if (is_seen(duration.seen)) {
+        merged[file] = {
+          {"ms",   duration.milliseconds},
+          {"seen", duration.seen        }
+        };
+      }
+    }
+    store[key_] = std::move(merged);
+
+    // Write to a temporary file first so that concurrent runners never
+    // observe a partially written store.
+    auto path = std::filesystem::path{store_file_};
+    auto ec   = std::error_code{};
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto temp = path;
+    temp     += fmt::format(".{}.tmp", ::getpid());
+    {
+      auto file = std::ofstream{temp};
+      if (!file.is_open()) {
+        spdlog::error("failed to save duration history to {}", store_file_);
+        return;
+      }
+      file << store.dump();
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+      spdlog::error("failed to save duration history to {}: {}", store_file_, ec.message());
+    }
+  }
+
+} // namespace lint
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace lint {
+  /// Per-file durations of previous runs, persisted as a small json file.
+  /// Durations are grouped by a key which is usually the tool name and version,
+  /// since a new tool version may have a totally different performance. Files
+  /// which aren't recorded for `max_unseen_days` are pruned, so durations of
+  /// deleted and renamed files don't pile up.
+  class duration_history {
+  public:
+    /// Load durations of the given key from the store file. A missing or
+    /// broken store file is treated as empty. An empty store file name keeps
+    /// durations in memory only.
+    duration_history(std::string store_file, std::string key);
+
+    /// Return the duration in milliseconds of the given file in previous runs.
+    auto lookup(const std::string &file) const -> std::optional<std::uint64_t>;
+
+    /// Record the duration in milliseconds of the given file. Thread safe.
+    void record(const std::string &file, std::uint64_t milliseconds);
+
+    /// Write recorded durations back to the store file. Durations of other
+    /// keys and files which aren't recorded in this run are kept, unless
+    /// they're pruned.
+    void save() const;
+
+    static constexpr auto max_unseen_days = std::int64_t{30};
+
+  private:
+    struct entry {
+      std::uint64_t milliseconds = 0;
+      // Days since epoch when the file was recorded last time.
+      std::int64_t seen = 0;
+    };
+
+    std::string store_file_;
+    std::string key_;
+    std::int64_t today_ = 0;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, entry> durations_;
+  };
+
+} // namespace lint
@@ -15,13 +15,16 @@
  */
 #include "git_utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <filesystem>
 #include <git2/buffer.h>
 #include <git2/diff.h>
+#include <git2/odb.h>
 #include <git2/patch.h>
 #include <git2/tree.h>
+#include <iterator>
 #include <string>
 
 #include <spdlog/spdlog.h>
@@ -498,6 +501,16 @@ namespace lint::git {
       return tree_to_tree(repo, *tree1, *tree2, init_option());
     }
 
+    auto commit_to_commit(
+      git_repository &repo,
+      git_commit &commit1,
+      git_commit &commit2,
+      const git_diff_options &opts) -> diff_ptr {
+      auto tree1 = commit::tree(commit1);
+      auto tree2 = commit::tree(commit2);
+      return tree_to_tree(repo, *tree1, *tree2, opts);
+    }
+
     auto get(git_repository &repo, git_commit &commit1, git_commit &commit2) -> diff_ptr {
       return commit_to_commit(repo, commit1, commit2);
     }
@@ -509,6 +522,18 @@ namespace lint::git {
       return opts;
     }
 
+    auto init_find_option() -> git_diff_find_options {
+      auto opts = git_diff_find_options{};
+      auto ret  = ::git_diff_find_options_init(&opts, GIT_DIFF_FIND_OPTIONS_VERSION);
+      throw_if(ret);
+      return opts;
+    }
+
+    void find_similar(git_diff &diff, const git_diff_find_options &opts) {
+      auto ret = ::git_diff_find_similar(&diff, &opts);
+      throw_if(ret);
+    }
+
     auto num_deltas(git_diff &diff) -> std::size_t {
       return ::git_diff_num_deltas(&diff);
     }
@@ -598,8 +623,22 @@ namespace lint::git {
       return oid;
     }
 
+    auto is_zero(const git_oid &oid) -> bool {
+      return ::git_oid_is_zero(&oid) == 1;
+    }
+
   } // namespace oid
 
+  namespace odb {
+    auto hash(std::string_view data, git_object_t type) -> git_oid {
+      auto oid = git_oid{};
+      auto ret = ::git_odb_hash(&oid, data.data(), data.size(), type);
+      throw_if(ret);
+      return oid;
+    }
+
+  } // namespace odb
+
   namespace ref {
     auto type(const git_reference &ref) -> git_reference_t {
       return ::git_reference_type(&ref);
@@ -792,6 +831,21 @@ namespace lint::git {
       return {*oid, entry};
     }
 
+    auto blob_id_bypath(const git_tree &tree, const std::string &path) -> std::optional<git_oid> {
+      auto *entry = static_cast<git_tree_entry *>(nullptr);
+      auto ret    = ::git_tree_entry_bypath(&entry, &tree, path.c_str());
+      if (ret == GIT_ENOTFOUND) {
+        return std::nullopt;
+      }
+      throw_if(ret);
+      auto guard = std::unique_ptr<git_tree_entry, decltype(::git_tree_entry_free) *>{
+        entry, ::git_tree_entry_free};
+      if (::git_tree_entry_type(entry) != GIT_OBJECT_BLOB) {
+        return std::nullopt;
+      }
+      return *::git_tree_entry_id(entry);
+    }
+
   } // namespace tree
 
   namespace status {
@@ -832,7 +886,7 @@ namespace lint::git {
     auto create_from_diff(git_diff &diff) -> std::unordered_map<std::string, patch_ptr> {
       auto res        = std::unordered_map<std::string, patch_ptr>{};
       auto num_deltas = git::diff::num_deltas(diff);
-      for (int i = 0; i < num_deltas; ++i) {
+      for (std::size_t i = 0; i < num_deltas; ++i) {
         auto patch        = git::patch::create_from_diff(diff, i);
         const auto *delta = git::patch::get_delta(*patch);
         res.insert({delta->new_file.path, std::move(patch)});
@@ -978,6 +1032,35 @@ namespace lint::git {
     }
   } // namespace hunk
 
+  hunk_index::hunk_index(git_patch &patch) {
+    auto num_hunks = git::patch::num_hunks(patch);
+    auto position  = std::size_t{0};
+    entries_.reserve(num_hunks);
+    for (std::size_t i = 0; i < num_hunks; ++i) {
+      auto [hunk, num_lines] = git::patch::get_hunk(patch, i);
+      entries_.push_back({hunk.new_start, hunk.new_lines, position});
+      position += num_lines;
+    }
+  }
+
+  auto hunk_index::position(int row) const -> std::optional<std::size_t> {
+    // The last hunk starting at or before the row is the only one which may
+    // contain it, since hunks don't overlap.
+    auto iter = std::ranges::upper_bound(entries_, row, {}, &entry::new_start);
+    if (iter == entries_.begin()) {
+      return std::nullopt;
+    }
+    const auto &hunk = *std::prev(iter);
+    if (row > hunk.new_start + hunk.new_lines) {
+      return std::nullopt;
+    }
+    return hunk.position + static_cast<std::size_t>(row - hunk.new_start) + 1;
+  }
+
+  auto hunk_index::size() const -> std::size_t {
+    return entries_.size();
+  }
+
   namespace blob {
     auto lookup(git_repository &repo, const git_oid &oid) -> blob_ptr {
       auto *blob = static_cast<git_blob *>(nullptr);
@@ -986,20 +1069,24 @@ namespace lint::git {
       return {blob, ::git_blob_free};
     }
 
+    auto view(git_repository &repo, const git_oid &oid) -> blob_view {
+      return blob_view{lookup(repo, oid)};
+    }
+
     auto get_raw_content(const git_blob &blob) -> std::string {
       const auto *ret = ::git_blob_rawcontent(&blob);
       throw_if(ret == nullptr, "get raw content by blob error");
-      return static_cast<const char *>(ret);
+      return {static_cast<const char *>(ret), static_cast<std::size_t>(::git_blob_rawsize(&blob))};
     }
 
     auto get_raw_content(git_repository &repo, const git_tree &tree, const std::string &file_name)
       -> std::string {
       throw_if(file_name.empty(), "failed to get raw content sicne file name is empty");
-      auto [entry_id, entry] = tree::entry_byname(tree, file_name);
-      if (entry == nullptr) {
+      auto entry_id = tree::blob_id_bypath(tree, file_name);
+      if (!entry_id) {
         return "";
       }
-      auto blob = lookup(repo, entry_id);
+      auto blob = lookup(repo, *entry_id);
       return get_raw_content(*blob);
     }
 
@@ -1012,4 +1099,19 @@ namespace lint::git {
 
   } // namespace blob
 
+  blob_view::blob_view(blob_ptr blob)
+    : blob_(std::move(blob)) {
+    throw_if(blob_ == nullptr, "blob view of a null blob");
+  }
+
+  auto blob_view::content() const -> std::string_view {
+    const auto *data = static_cast<const char *>(::git_blob_rawcontent(blob_.get()));
+    auto size        = static_cast<std::size_t>(::git_blob_rawsize(blob_.get()));
+    return {data, size};
+  }
+
+  auto blob_view::id() const -> const git_oid & {
+    return *::git_blob_id(blob_.get());
+  }
+
 } // namespace lint::git
@@ -21,6 +21,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -88,6 +89,20 @@ namespace lint::git {
     time when;
   };
 
+  /// A read only view of the raw content of a blob. It keeps the blob alive,
+  /// so the content isn't copied. The content may contain NUL bytes.
+  class blob_view {
+  public:
+    explicit blob_view(blob_ptr blob);
+
+    [[nodiscard]] auto content() const -> std::string_view;
+
+    [[nodiscard]] auto id() const -> const git_oid &;
+
+  private:
+    blob_ptr blob_;
+  };
+
   /// Init the global state.
   /// This must be used before any git operations.
   auto setup() -> int;
@@ -327,12 +342,27 @@ namespace lint::git {
     auto commit_to_commit(git_repository &repo, git_commit &commit1, git_commit &commit2)
       -> diff_ptr;
 
+    /// Create a diff with the difference between two commits with the given
+    /// options, such as a pathspec limiting the compared paths.
+    auto commit_to_commit(
+      git_repository &repo,
+      git_commit &commit1,
+      git_commit &commit2,
+      const git_diff_options &opts) -> diff_ptr;
+
     /// An utility to get diff.
     auto get(git_repository &repo, git_commit &commit1, git_commit &commit2) -> diff_ptr;
 
     /// Initialize diff options structure
     auto init_option() -> git_diff_options;
 
+    /// Initialize diff find options structure.
+    auto init_find_option() -> git_diff_find_options;
+
+    /// Transform a diff marking file renames, copies, etc. Pairs of added and
+    /// deleted files which are similar enough become one delta.
+    void find_similar(git_diff &diff, const git_diff_find_options &opts);
+
     /// Query how many diff records are there in a diff.
     auto num_deltas(git_diff &diff) -> std::size_t;
 
@@ -371,8 +401,18 @@ namespace lint::git {
 
     /// Parse a hex formatted object id into a git_oid.
     auto from_str(const std::string &str) -> git_oid;
+
+    /// Check whether the oid is all zeros, such as the id of a file missing
+    /// from one side of a diff.
+    auto is_zero(const git_oid &oid) -> bool;
   } // namespace oid
 
+  namespace odb {
+    /// Compute the object id of the given data as if it's an object of the
+    /// given type. The data isn't written to any object database.
+    auto hash(std::string_view data, git_object_t type) -> git_oid;
+  } // namespace odb
+
   namespace ref {
     /// Get the type of a reference.
     auto type(const git_reference &ref) -> git_reference_t;
@@ -575,6 +615,10 @@ namespace lint::git {
     auto entry_byname(const git_tree &tree, const std::string &filename)
       -> std::tuple<git_oid, const git_tree_entry *>;
 
+    /// Lookup the blob id of a file by its path relative to the tree root.
+    /// Return nullopt if the path doesn't exist or isn't a file.
+    auto blob_id_bypath(const git_tree &tree, const std::string &path) -> std::optional<git_oid>;
+
   } // namespace tree
 
   namespace status {
@@ -667,10 +711,37 @@ namespace lint::git {
     bool is_row_in_hunk(const git_diff_hunk &hunk, int row_number) noexcept;
   } // namespace hunk
 
+  /// Hunks of a patch sorted by their starts in the new file, with the diff
+  /// position each hunk starts at. It's built once per patch, then maps rows
+  /// of the new file to diff positions, as used by GitHub review comments, by
+  /// a binary search.
+  class hunk_index {
+  public:
+    explicit hunk_index(git_patch &patch);
+
+    /// Return the diff position of a row of the new file, or nullopt if the
+    /// row isn't in any hunk.
+    [[nodiscard]] auto position(int row) const -> std::optional<std::size_t>;
+
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    struct entry {
+      int new_start;
+      int new_lines;
+      std::size_t position;
+    };
+
+    std::vector<entry> entries_;
+  };
+
   namespace blob {
     /// Lookup a blob object from a repository.
     auto lookup(git_repository &repo, const git_oid &oid) -> blob_ptr;
 
+    /// Lookup a blob object and view its content without copying it.
+    auto view(git_repository &repo, const git_oid &oid) -> blob_view;
+
     /// Get a buffer with the raw content of a blob.
     auto get_raw_content(const git_blob &blob) -> std::string;
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/includes.h"
+
+#include <utility>
+
+namespace lint {
+  namespace {
+    constexpr auto blanks = std::string_view{" \t"};
+
+    auto skip_blanks(std::string_view line) -> std::string_view {
+      auto idx = line.find_first_not_of(blanks);
+      return idx == std::string_view::npos ? std::string_view{} : line.substr(idx);
+    }
+  } // namespace
+
+  auto find_includes(std::string_view source) -> std::vector<include_directive> {
+    constexpr auto directive = std::string_view{"include"};
+
+    auto res = std::vector<include_directive>{};
+    while (!source.empty()) {
+      auto end  = source.find('\n');
+      auto line = skip_blanks(source.substr(0, end));
+      source    = end == std::string_view::npos ? std::string_view{} : source.substr(end + 1);
+
+      if (!line.starts_with('#')) {
+        continue;
+      }
+      line = skip_blanks(line.substr(1));
+      if (!line.starts_with(directive)) {
+        continue;
+      }
+      line = skip_blanks(line.substr(directive.size()));
+      if (!line.starts_with('"') && !line.starts_with('<')) {
+        continue;
+      }
+      auto quoted = line.front() == '"';
+      auto close  = line.find(quoted ? '"' : '>', 1);
+      if (close != std::string_view::npos && close > 1) {
+        res.push_back({std::string{line.substr(1, close - 1)}, quoted});
+      }
+    }
+    return res;
+  }
+
+  auto quoted_includes(std::string_view source) -> std::vector<std::string> {
+    auto res = std::vector<std::string>{};
+    for (auto &include: find_includes(source)) {
+      if (include.quoted) {
+        res.push_back(std::move(include.path));
+      }
+    }
+    return res;
+  }
+
+} // namespace lint
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lint {
+  /// An include directive of a source.
+  struct include_directive {
+    std::string path;
+    // Whether it's `#include "path"` rather than `#include <path>`.
+    bool quoted = false;
+  };
+
+  /// Return include directives of the source in the order they appear.
+  auto find_includes(std::string_view source) -> std::vector<include_directive>;
+
+  /// Return paths of quoted includes, such as `#include "foo/bar.h"`, in the
+  /// order they appear in the source. Angle bracket includes are skipped
+  /// since they're usually found in system or third party directories.
+  auto quoted_includes(std::string_view source) -> std::vector<std::string>;
+
+} // namespace lint
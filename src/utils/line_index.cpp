@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/line_index.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define LINT_HAS_X86_SIMD 1
+#endif
+
+#include "utils/error.h"
+
+namespace lint {
+  namespace {
+    // memchr of glibc is vectorized as well, so this is only slower than the
+    // others by a call per line.
+    void find_scalar(std::string_view content, std::size_t from, std::vector<std::size_t> &starts) {
+      const auto *data = content.data();
+      const auto *last = data + content.size();
+      const auto *iter = data + from;
+      while (iter != last) {
+        const auto *found = static_cast<const char *>(std::memchr(iter, '\n', last - iter));
+        if (found == nullptr) {
+          return;
+        }
+        starts.push_back(found - data + 1);
+        iter = found + 1;
+      }
+    }
+
+#ifdef LINT_HAS_X86_SIMD
+    // Push offsets just past line feeds marked in the mask of a block.
+    template <typename Mask>
+    void push_marked(Mask mask, std::size_t block, std::vector<std::size_t> &starts) {
+      while (mask != 0) {
+        starts.push_back(block + std::countr_zero(mask) + 1);
+        mask &= mask - 1;
+      }
+    }
+
+    void find_sse2(std::string_view content, std::vector<std::size_t> &starts) {
+      constexpr auto width = std::size_t{16};
+      const auto *data     = content.data();
+      const auto newline   = _mm_set1_epi8('\n');
+      auto i               = std::size_t{0};
+      for (; i + width <= content.size(); i += width) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        auto mask  = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        push_marked(mask, i, starts);
+      }
+      find_scalar(content, i, starts);
+    }
+
+    __attribute__((target("avx2"))) void find_avx2(std::string_view content,
+                                                   std::vector<std::size_t> &starts) {
+      constexpr auto width = std::size_t{32};
+      const auto *data     = content.data();
+      const auto newline   = _mm256_set1_epi8('\n');
+      auto i               = std::size_t{0};
+      for (; i + width <= content.size(); i += width) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        auto mask =
+          static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+        push_marked(mask, i, starts);
+      }
+      find_scalar(content, i, starts);
+    }
+#endif
+  } // namespace
+
+  auto best_simd_level() noexcept -> simd_level {
+#ifdef LINT_HAS_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+      return simd_level::avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return simd_level::sse2;
+    }
+#endif
+    return simd_level::scalar;
+  }
+
+  auto find_line_starts(std::string_view content, simd_level level) -> std::vector<std::size_t> {
+    auto starts = std::vector<std::size_t>{0};
+    switch (level) {
+#ifdef LINT_HAS_X86_SIMD
+    case simd_level::avx2:
+      find_avx2(content, starts);
+      break;
+    case simd_level::sse2:
+      find_sse2(content, starts);
+      break;
+#endif
+    default:
+      find_scalar(content, 0, starts);
+      break;
+    }
+    return starts;
+  }
+
+  mapped_file::mapped_file(const std::string &path) {
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    throw_if(fd < 0, fmt::format("open file {} error", path));
+    struct stat info {};
+    auto ret = ::fstat(fd, &info);
+    if (ret != 0) {
+      ::close(fd);
+    }
+    throw_if(ret != 0, fmt::format("stat file {} error", path));
+    size_ = static_cast<std::size_t>(info.st_size);
+    // Empty files can't be mapped.
+    if (size_ != 0) {
+      data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    throw_if(data_ == MAP_FAILED, fmt::format("map file {} error", path));
+  }
+
+  mapped_file::~mapped_file() {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+  }
+
+  auto mapped_file::content() const noexcept -> std::string_view {
+    return {static_cast<const char *>(data_), size_};
+  }
+
+  line_index::line_index(std::string_view content)
+    : starts_(find_line_starts(content, best_simd_level())) {
+    // A line feed ends its line, so the offset past a trailing one doesn't
+    // start a new line.
+    end_ = content.ends_with('\n') ? content.size() : content.size() + 1;
+    if (starts_.back() == content.size()) {
+      starts_.pop_back();
+    }
+  }
+
+  auto line_index::position(std::size_t offset) const -> std::tuple<std::int32_t, std::int32_t> {
+    if (offset >= end_ || starts_.empty()) {
+      return {-1, -1};
+    }
+    auto iter  = std::ranges::upper_bound(starts_, offset);
+    auto row   = std::distance(starts_.begin(), iter);
+    auto start = *std::prev(iter);
+    return {static_cast<std::int32_t>(row), static_cast<std::int32_t>(offset - start + 1)};
+  }
+
+  auto line_index::num_lines() const noexcept -> std::size_t {
+    return starts_.size();
+  }
+
+} // namespace lint
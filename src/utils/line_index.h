@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace lint {
+  /// Instruction sets used to find line feeds.
+  enum class simd_level : std::uint8_t {
+    scalar,
+    sse2,
+    avx2,
+  };
+
+  /// Return the widest instruction set supported by the running CPU.
+  auto best_simd_level() noexcept -> simd_level;
+
+  /// Return offsets of all line starts, which are 0 and offsets just past
+  /// each line feed. The given instruction set must be supported.
+  auto find_line_starts(std::string_view content, simd_level level) -> std::vector<std::size_t>;
+
+  /// A read only memory map of a whole file.
+  class mapped_file {
+  public:
+    explicit mapped_file(const std::string &path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file &)            = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    mapped_file(mapped_file &&)                 = delete;
+    mapped_file &operator=(mapped_file &&)      = delete;
+
+    [[nodiscard]] auto content() const noexcept -> std::string_view;
+
+  private:
+    void *data_       = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  /// Offsets of line starts of a buffer, which map byte offsets to rows and
+  /// columns by a binary search. Lines end with a line feed, so a carriage
+  /// return of CRLF is the last column of its line. The buffer isn't kept.
+  class line_index {
+  public:
+    explicit line_index(std::string_view content);
+
+    /// Return the 1-based row and column of a 0-based byte offset, or
+    /// {-1, -1} if the offset isn't in any line. The end of a last line
+    /// without a line feed is still in that line.
+    [[nodiscard]] auto position(std::size_t offset) const -> std::tuple<std::int32_t, std::int32_t>;
+
+    [[nodiscard]] auto num_lines() const noexcept -> std::size_t;
+
+  private:
+    std::vector<std::size_t> starts_;
+    // One past the last offset in any line.
+    std::size_t end_ = 0;
+  };
+
+} // namespace lint
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/lsp.h"
+
+#include <cctype>
+#include <cstdlib>
+
+#include <fmt/format.h>
+
+#include "utils/common.h"
+#include "utils/error.h"
+
+namespace lint::lsp {
+  namespace {
+    constexpr auto header_end     = std::string_view{"\r\n\r\n"};
+    constexpr auto content_length = std::string_view{"Content-Length:"};
+    constexpr auto file_scheme    = std::string_view{"file://"};
+
+    auto is_unreserved(char chr) -> bool {
+      return std::isalnum(static_cast<unsigned char>(chr)) != 0
+          || chr == '-'
+          || chr == '.'
+          || chr == '_'
+          || chr == '~'
+          || chr == '/';
+    }
+  } // namespace
+
+  auto encode(const nlohmann::json &message) -> std::string {
+    auto content = message.dump();
+    return fmt::format("Content-Length: {}\r\n\r\n{}", content.size(), content);
+  }
+
+  void message_reader::feed(std::string_view data) {
+    buffer_.append(data);
+  }
+
+  auto message_reader::next() -> std::optional<nlohmann::json> {
+    auto end = buffer_.find(header_end);
+    if (end == std::string::npos) {
+      return std::nullopt;
+    }
+
+    // Headers other than Content-Length, such as Content-Type, are ignored.
+    auto length = std::optional<std::size_t>{};
+    auto header = std::string_view{buffer_}.substr(0, end);
+    while (!header.empty()) {
+      auto line_end = header.find("\r\n");
+      auto line     = header.substr(0, line_end);
+      if (line.starts_with(content_length)) {
+        auto value = trim(line.substr(content_length.size()));
+        length     = std::strtoull(std::string{value}.c_str(), nullptr, 10);
+      }
+      header = line_end == std::string_view::npos ? std::string_view{}
+                                                  : header.substr(line_end + 2);
+    }
+    throw_unless(length.has_value(), "LSP message doesn't have Content-Length header");
+
+    auto start = end + header_end.size();
+    if (buffer_.size() < start + *length) {
+      return std::nullopt;
+    }
+    auto message = nlohmann::json::parse(buffer_.substr(start, *length));
+    buffer_.erase(0, start + *length);
+    return message;
+  }
+
+  auto path_to_uri(std::string_view path) -> std::string {
+    auto uri = std::string{file_scheme};
+    for (auto chr: path) {
+      if (is_unreserved(chr)) {
+        uri += chr;
+      } else {
+        uri += fmt::format("%{:02X}", static_cast<unsigned char>(chr));
+      }
+    }
+    return uri;
+  }
+
+  auto uri_to_path(std::string_view uri) -> std::string {
+    throw_unless(uri.starts_with(file_scheme), fmt::format("unsupported uri: {}", uri));
+    uri.remove_prefix(file_scheme.size());
+
+    auto path = std::string{};
+    for (std::size_t i = 0; i < uri.size(); ++i) {
+      if (uri[i] == '%' && i + 2 < uri.size()) {
+        path += static_cast<char>(std::stoi(std::string{uri.substr(i + 1, 2)}, nullptr, 16));
+        i    += 2;
+        continue;
+      }
+      path += uri[i];
+    }
+    return path;
+  }
+
+} // namespace lint::lsp
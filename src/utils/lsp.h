@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace lint::lsp {
+  /// Encode a json-rpc message with the header of the LSP base protocol.
+  auto encode(const nlohmann::json &message) -> std::string;
+
+  /// Split json-rpc messages from a byte stream of the LSP base protocol.
+  class message_reader {
+  public:
+    /// Append data read from the stream.
+    void feed(std::string_view data);
+
+    /// Pop the next complete message, or std::nullopt if more data is needed.
+    auto next() -> std::optional<nlohmann::json>;
+
+  private:
+    std::string buffer_;
+  };
+
+  /// Convert an absolute path to a file uri.
+  auto path_to_uri(std::string_view path) -> std::string;
+
+  /// Convert a file uri to an absolute path.
+  auto uri_to_path(std::string_view uri) -> std::string;
+
+} // namespace lint::lsp
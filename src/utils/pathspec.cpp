@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/pathspec.h"
+
+#include <cctype>
+#include <string_view>
+
+#include <range/v3/algorithm/contains.hpp>
+
+namespace lint {
+  namespace {
+    // Translate one alternative of the extension group, where letters match
+    // either case. Only plain characters and escaped punctuations are allowed.
+    auto extension_to_glob(std::string_view ext) -> std::optional<std::string> {
+      auto glob = std::string{"*."};
+      for (std::size_t i = 0; i < ext.size(); ++i) {
+        auto chr = static_cast<unsigned char>(ext[i]);
+        if (chr == '\\' && i + 1 < ext.size()
+            && std::ispunct(static_cast<unsigned char>(ext[i + 1])) != 0) {
+          auto escaped = ext[++i];
+          if (escaped == '*' || escaped == '?' || escaped == '[') {
+            glob += '\\';
+          }
+          glob += escaped;
+        } else if (std::isalpha(chr) != 0) {
+          glob += '[';
+          glob += static_cast<char>(std::tolower(chr));
+          glob += static_cast<char>(std::toupper(chr));
+          glob += ']';
+        } else if (std::isdigit(chr) != 0 || chr == '_' || chr == '-') {
+          glob += static_cast<char>(chr);
+        } else {
+          return std::nullopt;
+        }
+      }
+      if (glob.size() == 2) {
+        return std::nullopt;
+      }
+      return glob;
+    }
+  } // namespace
+
+  auto iregex_to_globs(const std::string &iregex) -> std::optional<std::vector<std::string>> {
+    constexpr auto prefix = std::string_view{R"(.*\.)"};
+    auto regex            = std::string_view{iregex};
+    if (!regex.starts_with(prefix)) {
+      return std::nullopt;
+    }
+    regex.remove_prefix(prefix.size());
+    if (regex.starts_with('(') && regex.ends_with(')')) {
+      regex = regex.substr(1, regex.size() - 2);
+    }
+
+    auto globs = std::vector<std::string>{};
+    while (true) {
+      auto end  = std::min(regex.find('|'), regex.size());
+      auto glob = extension_to_glob(regex.substr(0, end));
+      if (!glob) {
+        return std::nullopt;
+      }
+      if (!ranges::contains(globs, *glob)) {
+        globs.push_back(std::move(*glob));
+      }
+      if (end == regex.size()) {
+        break;
+      }
+      regex.remove_prefix(end + 1);
+    }
+    return globs;
+  }
+
+  auto make_pathspec(const std::vector<std::string> &includes,
+                     const std::vector<std::string> &excludes) -> std::vector<std::string> {
+    auto pathspec = std::vector<std::string>{};
+    for (const auto &exclude: excludes) {
+      pathspec.push_back("!" + exclude);
+    }
+    pathspec.insert(pathspec.end(), includes.begin(), includes.end());
+    // Paths not matched by any pattern are dropped, so the remaining paths
+    // must be matched explicitly if only excludes are given.
+    if (!excludes.empty() && includes.empty()) {
+      pathspec.emplace_back("*");
+    }
+    return pathspec;
+  }
+
+} // namespace lint
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lint {
+  /// Translate a file filter iregex of the form `.*\.ext` or `.*\.(ext|...)`
+  /// into globs matching the same files, such as `*.[cC][pP][pP]`. Return
+  /// std::nullopt for other iregexes, which can't be expressed by globs.
+  auto iregex_to_globs(const std::string &iregex) -> std::optional<std::vector<std::string>>;
+
+  /// Make a libgit2 pathspec which matches paths matched by any of `includes`
+  /// but none of `excludes`. libgit2 stops at the first matching pattern, so
+  /// negative patterns are placed first. An empty pathspec matches all paths.
+  auto make_pathspec(const std::vector<std::string> &includes,
+                     const std::vector<std::string> &excludes) -> std::vector<std::string>;
+
+} // namespace lint
@@ -16,136 +16,417 @@
 #include "shell.h"
 
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 
 #define BOOST_PROCESS_V2_SEPARATE_COMPILATION
 #include <boost/asio/error.hpp>
-#include <boost/asio/read.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/readable_pipe.hpp>
+#include <boost/asio/writable_pipe.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/process/v2.hpp>
 #include <boost/process/v2/src.hpp>
 #include <boost/process/v2/start_dir.hpp>
+#include <unistd.h>
 
-#include "utils/error.h"
 #include "utils/common.h"
+#include "utils/error.h"
 
 namespace lint::shell {
   namespace bp = boost::process::v2;
 
+  namespace {
+    /// The io_context shared by all children. It runs on a dedicated thread
+    /// until the program exits.
+    class reactor {
+    public:
+      static auto instance() -> reactor & {
+        static auto the_reactor = reactor{};
+        return the_reactor;
+      }
+
+      reactor(const reactor &)            = delete;
+      reactor &operator=(const reactor &) = delete;
+      reactor(reactor &&)                 = delete;
+      reactor &operator=(reactor &&)      = delete;
+
+      ~reactor() {
+        guard_.reset();
+        context_.stop();
+        thread_.join();
+      }
+
+      auto context() -> boost::asio::io_context & {
+        return context_;
+      }
+
+    private:
+      reactor()
+        : guard_(boost::asio::make_work_guard(context_))
+        , thread_([this] { context_.run(); }) {
+      }
+
+      boost::asio::io_context context_;
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type> guard_;
+      std::thread thread_;
+    };
+
+    /// Maximum bytes kept of each output stream of a child.
+    constexpr auto max_output_size = std::size_t{64} * 1024 * 1024;
+    constexpr auto read_chunk_size = std::size_t{64} * 1024;
+
+    /// An output stream of a child. Its output grows with what the child
+    /// writes but stops at max_output_size. The rest is still read so that the
+    /// child never blocks on a full pipe, but it's dropped.
+    struct output_stream {
+      output_stream(boost::asio::io_context &context, std::string_view name)
+        : pipe(context)
+        , name(name) {
+      }
+
+      boost::asio::readable_pipe pipe;
+      std::string_view name;
+      std::array<char, read_chunk_size> chunk{};
+      std::size_t dropped = 0;
+    };
+
+    /// The state of a child process shared by its asynchronous operations.
+    /// It's only touched on the reactor thread.
+    struct child {
+      child(boost::asio::io_context &context, std::string_view command)
+        : command(command)
+        , out(context, "stdout")
+        , err(context, "stderr") {
+      }
+
+      // Fulfill the promise after stdout, stderr and the exit are all done.
+      void complete_one() {
+        if (--pending != 0) {
+          return;
+        }
+        if (error) {
+          promise.set_exception(error);
+        } else {
+          promise.set_value(std::move(res));
+        }
+      }
+
+      void fail(std::string message) {
+        if (!error) {
+          error = std::make_exception_ptr(std::runtime_error{std::move(message)});
+        }
+      }
+
+      std::string command;
+      output_stream out;
+      output_stream err;
+      std::optional<bp::process> proc;
+      bool exited = false;
+      result res{};
+      int pending = 3;
+      std::exception_ptr error;
+      std::promise<result> promise;
+    };
+
+    using child_ptr = std::shared_ptr<child>;
+  } // namespace
+
+  struct process_group::impl {
+    std::mutex mutex;
+    bool killed = false;
+    std::vector<std::weak_ptr<child>> children;
+  };
+
+  namespace {
+
+    // Both streams are drained concurrently, otherwise a child filling the
+    // pipe of one stream blocks forever while the other one is being read.
+    void async_drain(const child_ptr &state, output_stream &stream, std::string &output) {
+      stream.pipe.async_read_some(
+        boost::asio::buffer(stream.chunk),
+        [state, &stream, &output](boost::system::error_code ec, std::size_t size) {
+          auto kept = std::min(size, max_output_size - output.size());
+          output.append(stream.chunk.data(), kept);
+          stream.dropped += size - kept;
+          if (!ec) {
+            async_drain(state, stream, output);
+            return;
+          }
+
+          if (ec != boost::asio::error::eof) {
+            state->fail(fmt::format("Read {} message of {} faild since {}",
+                                    stream.name,
+                                    state->command,
+                                    ec.message()));
+          }
+          if (stream.dropped != 0) {
+            spdlog::warn("Dropped {} bytes of {} of {} since it exceeds {} bytes",
+                         stream.dropped,
+                         stream.name,
+                         state->command,
+                         max_output_size);
+          }
+          state->complete_one();
+        });
+    }
+
+    auto spawn(boost::asio::io_context &context,
+               child &state,
+               const options &opts,
+               const std::optional<envrionment> &env,
+               const std::optional<std::string> &start_dir) -> bp::process {
+      auto stdio = bp::process_stdio{.in = {}, .out = state.out.pipe, .err = state.err.pipe};
+      if (env && start_dir) {
+        return bp::process{context,
+                           state.command,
+                           opts,
+                           stdio,
+                           bp::process_environment{*env},
+                           bp::process_start_dir{*start_dir}};
+      }
+      if (env) {
+        return bp::process{context, state.command, opts, stdio, bp::process_environment{*env}};
+      }
+      if (start_dir) {
+        return bp::process{context, state.command, opts, stdio, bp::process_start_dir{*start_dir}};
+      }
+      return bp::process{context, state.command, opts, stdio};
+    }
+
+    auto launch(std::string_view command,
+                const options &opts,
+                std::optional<envrionment> env,
+                std::optional<std::string> start_dir,
+                process_group::impl *group = nullptr) -> std::future<result> {
+      auto &context = reactor::instance().context();
+      auto state    = std::make_shared<child>(context, command);
+      auto future   = state->promise.get_future();
+
+      // The child is posted under the lock of its group, so it's spawned
+      // before any kill posted later.
+      auto lock = std::unique_lock<std::mutex>{};
+      if (group != nullptr) {
+        lock = std::unique_lock{group->mutex};
+        if (group->killed) {
+          state->promise.set_value({.exit_code = -1, .std_out = "", .std_err = "killed"});
+          return future;
+        }
+        std::erase_if(group->children, [](const auto &weak) { return weak.expired(); });
+        group->children.push_back(state);
+      }
+
+      // Pipes and processes aren't thread safe, so they're only touched on
+      // the reactor thread.
+      boost::asio::post(
+        context,
+        [&context,
+         state,
+         opts      = opts,
+         env       = std::move(env),
+         start_dir = std::move(start_dir)] {
+          try {
+            state->proc.emplace(spawn(context, *state, opts, env, start_dir));
+          } catch (...) {
+            state->promise.set_exception(std::current_exception());
+            return;
+          }
+
+          async_drain(state, state->out, state->res.std_out);
+          async_drain(state, state->err, state->res.std_err);
+          state->proc->async_wait([state](boost::system::error_code ec, int exit_code) {
+            if (ec) {
+              state->fail(fmt::format("Wait {} faild since {}", state->command, ec.message()));
+            }
+            state->res.exit_code = exit_code;
+            state->exited        = true;
+            state->complete_one();
+          });
+        });
+      return future;
+    }
+  } // namespace
+
+  auto async_execute(std::string_view command, const options &opts) -> std::future<result> {
+    return launch(command, opts, std::nullopt, std::nullopt);
+  }
+
+  auto async_execute(std::string_view command, const options &opts, std::string_view start_dir)
+    -> std::future<result> {
+    return launch(command, opts, std::nullopt, std::string{start_dir});
+  }
+
+  auto async_execute(std::string_view command, const options &opts, const envrionment &env)
+    -> std::future<result> {
+    return launch(command, opts, env, std::nullopt);
+  }
+
+  auto async_execute(std::string_view command,
+                     const options &opts,
+                     const envrionment &env,
+                     std::string_view start_dir) -> std::future<result> {
+    return launch(command, opts, env, std::string{start_dir});
+  }
+
   auto execute(std::string_view command, const options &opts) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts).get();
   }
 
   auto execute(std::string_view command, const options &opts, std::string_view start_dir)
     -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_start_dir{start_dir});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, start_dir).get();
   }
 
   auto execute(std::string_view command, const options &opts, const envrionment &env) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_environment{env});
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, env).get();
   }
 
   auto execute(std::string_view command,
                const options &opts,
                const envrionment &env,
                std::string_view start_dir) -> result {
-    auto context = boost::asio::io_context{};
-    auto rp_out  = boost::asio::readable_pipe{context};
-    auto rp_err  = boost::asio::readable_pipe{context};
-
-    auto proc = bp::process(
-      context,
-      command,
-      opts,
-      bp::process_stdio{.in = {}, .out = rp_out, .err = rp_err},
-      bp::process_environment{env},
-      bp::process_start_dir(start_dir));
-    auto ec  = boost::system::error_code{};
-    auto res = result{};
-    boost::asio::read(rp_out, boost::asio::dynamic_buffer(res.std_out), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stdout message of {} faild since {}", command, ec.message()));
-    ec.clear();
-
-    boost::asio::read(rp_err, boost::asio::dynamic_buffer(res.std_err), ec);
-    throw_if(ec && ec != boost::asio::error::eof,
-             fmt::format("Read stderr message of {} faild since {}", command, ec.message()));
-
-    res.exit_code = proc.wait();
-    return res;
+    return async_execute(command, opts, env, start_dir).get();
+  }
+
+  process_group::process_group()
+    : impl_(std::make_shared<impl>()) {
+  }
+
+  auto process_group::async_execute(std::string_view command,
+                                    const options &opts,
+                                    std::string_view start_dir) const -> std::future<result> {
+    return launch(command, opts, std::nullopt, std::string{start_dir}, impl_.get());
+  }
+
+  auto process_group::execute(std::string_view command,
+                              const options &opts,
+                              std::string_view start_dir) const -> result {
+    return async_execute(command, opts, start_dir).get();
+  }
+
+  void process_group::kill() {
+    auto lock = std::lock_guard{impl_->mutex};
+    if (impl_->killed) {
+      return;
+    }
+    impl_->killed = true;
+    boost::asio::post(reactor::instance().context(), [children = impl_->children] {
+      for (const auto &weak: children) {
+        auto state = weak.lock();
+        if (!state || !state->proc || state->exited) {
+          continue;
+        }
+        spdlog::debug("Kill {} since its group is killed", state->command);
+        auto ec = boost::system::error_code{};
+        state->proc->terminate(ec);
+      }
+    });
+  }
+
+  auto process_group::killed() const -> bool {
+    auto lock = std::lock_guard{impl_->mutex};
+    return impl_->killed;
+  }
+
+  struct interactive_process::impl {
+    explicit impl(std::string_view command)
+      : command(command) {
+    }
+
+    std::string command;
+    boost::asio::io_context context;
+    boost::asio::writable_pipe wp_in{context};
+    boost::asio::readable_pipe rp_out{context};
+    std::optional<bp::process> proc;
+    std::array<char, read_chunk_size> chunk{};
+  };
+
+  interactive_process::interactive_process(std::string_view command,
+                                           const options &opts,
+                                           std::string_view start_dir)
+    : impl_(std::make_unique<impl>(command)) {
+    impl_->proc.emplace(impl_->context,
+                        impl_->command,
+                        opts,
+                        bp::process_stdio{.in = impl_->wp_in, .out = impl_->rp_out, .err = nullptr},
+                        bp::process_start_dir{start_dir});
+  }
+
+  interactive_process::~interactive_process() {
+    auto ec = boost::system::error_code{};
+    if (impl_->proc && impl_->proc->running(ec)) {
+      impl_->proc->terminate(ec);
+    }
+  }
+
+  void interactive_process::write(std::string_view data) {
+    auto ec = boost::system::error_code{};
+    boost::asio::write(impl_->wp_in, boost::asio::buffer(data), ec);
+    throw_if(static_cast<bool>(ec),
+             fmt::format("Write stdin of {} faild since {}", impl_->command, ec.message()));
+  }
+
+  auto interactive_process::read_some() -> std::string {
+    auto ec   = boost::system::error_code{};
+    auto size = impl_->rp_out.read_some(boost::asio::buffer(impl_->chunk), ec);
+    if (ec == boost::asio::error::eof) {
+      return {};
+    }
+    throw_if(static_cast<bool>(ec),
+             fmt::format("Read stdout message of {} faild since {}", impl_->command, ec.message()));
+    return {impl_->chunk.data(), size};
+  }
+
+  auto interactive_process::wait() -> int {
+    auto ec = boost::system::error_code{};
+    impl_->wp_in.close(ec);
+    return impl_->proc->wait();
   }
 
   auto which(std::string command) -> result {
-    constexpr auto which = std::string_view{"/usr/bin/which"};
-    auto res             = execute(which, {std::move(command)});
-    res.std_out          = trim(res.std_out);
-    return res;
+    auto is_executable = [](const std::filesystem::path &path) {
+      auto ec = std::error_code{};
+      return std::filesystem::is_regular_file(path, ec) && ::access(path.c_str(), X_OK) == 0;
+    };
+
+    // Like `which`, a command with a slash isn't searched in $PATH.
+    if (command.find('/') != std::string::npos) {
+      if (is_executable(command)) {
+        return {.exit_code = 0, .std_out = std::move(command), .std_err = ""};
+      }
+      auto message = fmt::format("{} isn't executable", command);
+      return {.exit_code = 1, .std_out = "", .std_err = std::move(message)};
+    }
+
+    const auto *env = std::getenv("PATH");
+    auto paths      = std::string_view{env != nullptr ? env : "/usr/local/bin:/usr/bin:/bin"};
+    while (true) {
+      auto end = std::min(paths.find(':'), paths.size());
+      auto dir = paths.substr(0, end);
+      // An empty entry means the current directory.
+      auto path = std::filesystem::path{dir.empty() ? "." : std::string{dir}} / command;
+      if (is_executable(path)) {
+        return {.exit_code = 0, .std_out = path.string(), .std_err = ""};
+      }
+      if (end == paths.size()) {
+        break;
+      }
+      paths.remove_prefix(end + 1);
+    }
+    return {.exit_code = 1, .std_out = "", .std_err = fmt::format("no {} in $PATH", command)};
   }
 
 } // namespace lint::shell
@@ -15,7 +15,10 @@
  */
 #pragma once
 
+#include <future>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +32,21 @@ namespace lint::shell {
   using envrionment = std::unordered_map<std::string, std::string>;
   using options     = std::vector<std::string>;
 
+  /// Start the command and return the future of its result. All children
+  /// share one io_context running on a background thread, which reads their
+  /// outputs without blocking, so waiting for many children doesn't cost a
+  /// thread for each of them.
+  auto async_execute(std::string_view command, const options &opts) -> std::future<result>;
+  auto async_execute(std::string_view command, const options &opts, std::string_view start_dir)
+    -> std::future<result>;
+  auto async_execute(std::string_view command, const options &opts, const envrionment &env)
+    -> std::future<result>;
+  auto async_execute(std::string_view command,
+                     const options &opts,
+                     const envrionment &env,
+                     std::string_view start_dir) -> std::future<result>;
+
+  /// Execute the command and block until it exits.
   auto execute(std::string_view command, const options &opts) -> result;
   auto execute(std::string_view command, const options &opts, std::string_view start_dir) -> result;
   auto execute(std::string_view command, const options &opts, const envrionment &env) -> result;
@@ -37,5 +55,59 @@ namespace lint::shell {
                const envrionment &env,
                std::string_view start_dir) -> result;
 
+  /// Children started through a group can be killed together, such as the
+  /// running children of a tool which exits fastly. It's thread safe.
+  class process_group {
+  public:
+    process_group();
+
+    /// Like shell::async_execute, but a child started after kill() isn't
+    /// spawned, and its result has an exit code of -1.
+    auto async_execute(std::string_view command,
+                       const options &opts,
+                       std::string_view start_dir) const -> std::future<result>;
+    auto execute(std::string_view command, const options &opts, std::string_view start_dir) const
+      -> result;
+
+    /// Kill all running children of the group and refuse to start others.
+    void kill();
+
+    [[nodiscard]] auto killed() const -> bool;
+
+    struct impl;
+
+  private:
+    std::shared_ptr<impl> impl_;
+  };
+
+  /// Find the executable of the command in $PATH like `which`. It runs in
+  /// process, since tools are looked up on every startup.
   auto which(std::string command) -> result;
+
+  /// A long-lived child talked with through its stdin and stdout, such as a
+  /// language server. Its stderr is discarded. It's not thread safe.
+  class interactive_process {
+  public:
+    interactive_process(std::string_view command, const options &opts, std::string_view start_dir);
+    ~interactive_process();
+
+    interactive_process(const interactive_process &)            = delete;
+    interactive_process &operator=(const interactive_process &) = delete;
+    interactive_process(interactive_process &&)                 = delete;
+    interactive_process &operator=(interactive_process &&)      = delete;
+
+    /// Write all data to the stdin of the child.
+    void write(std::string_view data);
+
+    /// Block until some data is read from the stdout of the child. Return an
+    /// empty string if the child closed its stdout.
+    auto read_some() -> std::string;
+
+    /// Close the stdin of the child and wait for it to exit.
+    auto wait() -> int;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+  };
 } // namespace lint::shell
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <sched.h>
+
+namespace lint {
+  thread_pool::thread_pool(std::size_t num_workers) {
+    num_workers = std::max<std::size_t>(num_workers, 1);
+    workers_.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  thread_pool::~thread_pool() {
+    {
+      auto lock = std::lock_guard{mutex_};
+      stopping_ = true;
+    }
+    task_cv_.notify_all();
+    for (auto &worker: workers_) {
+      worker.join();
+    }
+  }
+
+  void thread_pool::submit(std::function<void()> task) {
+    {
+      auto lock = std::lock_guard{mutex_};
+      tasks_.emplace_back(std::move(task));
+    }
+    task_cv_.notify_one();
+  }
+
+  void thread_pool::wait() {
+    auto lock = std::unique_lock{mutex_};
+    idle_cv_.wait(lock, [this] { return tasks_.empty() && running_ == 0; });
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+  auto thread_pool::size() const noexcept -> std::size_t {
+    return workers_.size();
+  }
+
+  void thread_pool::work() {
+    while (true) {
+      auto task = std::function<void()>{};
+      {
+        auto lock = std::unique_lock{mutex_};
+        task_cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+        ++running_;
+      }
+
+      try {
+        task();
+      } catch (...) {
+        auto lock = std::lock_guard{mutex_};
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+
+      {
+        auto lock = std::lock_guard{mutex_};
+        --running_;
+      }
+      idle_cv_.notify_all();
+    }
+  }
+
+  auto usable_cpu_count() noexcept -> std::size_t {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+      auto count = CPU_COUNT(&set);
+      if (count > 0) {
+        return static_cast<std::size_t>(count);
+      }
+    }
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+} // namespace lint
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lint {
+  /// A fixed size pool of worker threads. Tasks are started in the order they
+  /// are submitted.
+  class thread_pool {
+  public:
+    explicit thread_pool(std::size_t num_workers);
+    ~thread_pool();
+
+    thread_pool(const thread_pool &)            = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+    thread_pool(thread_pool &&)                 = delete;
+    thread_pool &operator=(thread_pool &&)      = delete;
+
+    /// Submit a task to the pool.
+    void submit(std::function<void()> task);
+
+    /// Block until all submitted tasks are finished. The first exception thrown
+    /// by a task is rethrown here.
+    void wait();
+
+    /// Return the number of worker threads.
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+  private:
+    void work();
+
+    std::mutex mutex_;
+    std::condition_variable task_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    std::size_t running_ = 0;
+    bool stopping_       = false;
+    std::exception_ptr error_;
+  };
+
+  /// Return the number of CPUs this process is allowed to run on. This
+  /// respects CPU affinity, so it's usually smaller than the hardware
+  /// concurrency on containerized CI runners.
+  auto usable_cpu_count() noexcept -> std::size_t;
+
+} // namespace lint
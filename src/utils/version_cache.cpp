@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/version_cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/shell.h"
+
+namespace lint {
+  namespace {
+    auto read_store(const std::string &store_file) -> nlohmann::json {
+      auto file = std::ifstream{store_file};
+      if (!file.is_open()) {
+        return nlohmann::json::object();
+      }
+      auto store = nlohmann::json::parse(file, nullptr, false);
+      if (store.is_discarded() || !store.is_object()) {
+        spdlog::debug("ignore broken version cache {}", store_file);
+        return nlohmann::json::object();
+      }
+      return store;
+    }
+
+    // Resolve the binary to the file which really runs, so that symlinks such
+    // as clang-format -> clang-format-18 share one entry.
+    auto resolve(const std::string &binary) -> std::string {
+      auto path = binary;
+      if (binary.find('/') == std::string::npos) {
+        auto [ec, std_out, std_err] = shell::which(binary);
+        if (ec != 0) {
+          return "";
+        }
+        path = std_out;
+      }
+      auto ec       = std::error_code{};
+      auto resolved = std::filesystem::canonical(path, ec);
+      return ec ? "" : resolved.string();
+    }
+  } // namespace
+
+  auto probe_version(const std::string &binary) -> std::optional<std::string> {
+    auto [ec, std_out, std_err] = shell::execute(binary, {"--version"});
+    if (ec != 0) {
+      return std::nullopt;
+    }
+    return std_out;
+  }
+
+  version_cache::version_cache(std::string store_file)
+    : store_file_(std::move(store_file)) {
+    if (store_file_.empty()) {
+      return;
+    }
+    auto store = read_store(store_file_);
+    for (const auto &[path, value]: store.items()) {
+      try {
+        auto &cached = entries_[path];
+        value.at("inode").get_to(cached.inode);
+        value.at("mtime").get_to(cached.mtime);
+        value.at("size").get_to(cached.size);
+        value.at("output").get_to(cached.output);
+      } catch (const nlohmann::json::exception &err) {
+        spdlog::debug("ignore broken version cache entry {}: {}", path, err.what());
+        entries_.erase(path);
+      }
+    }
+    spdlog::debug("loaded {} tool versions from {}", entries_.size(), store_file_);
+  }
+
+  auto version_cache::probe(const std::string &binary) -> std::optional<std::string> {
+    auto path = resolve(binary);
+    struct stat info {};
+    if (path.empty() || ::stat(path.c_str(), &info) != 0) {
+      return probe_version(binary);
+    }
+    auto probed  = entry{};
+    probed.inode = info.st_ino;
+    probed.mtime = (static_cast<std::uint64_t>(info.st_mtim.tv_sec) * 1'000'000'000)
+                 + info.st_mtim.tv_nsec;
+    probed.size  = info.st_size;
+
+    {
+      auto lock = std::lock_guard{mutex_};
+      if (auto iter = entries_.find(path); iter != entries_.end()) {
+        const auto &cached = iter->second;
+        if (cached.inode == probed.inode && cached.mtime == probed.mtime
+            && cached.size == probed.size) {
+          spdlog::debug("version of {} is served by cache", path);
+          return cached.output;
+        }
+      }
+    }
+
+    // Probe without the lock, so different binaries are probed concurrently.
+    auto output = probe_version(binary);
+    if (!output) {
+      return std::nullopt;
+    }
+    probed.output = *output;
+
+    auto lock      = std::lock_guard{mutex_};
+    entries_[path] = std::move(probed);
+    modified_      = true;
+    return output;
+  }
+
+  void version_cache::save() const {
+    auto lock = std::lock_guard{mutex_};
+    if (store_file_.empty() || !modified_) {
+      return;
+    }
+    auto store = read_store(store_file_);
+    for (const auto &[path, cached]: entries_) {
+      store[path] = {
+        {"inode",  cached.inode },
+        {"mtime",  cached.mtime },
+        {"size",   cached.size  },
+        {"output", cached.output}
+      };
+    }
+
+    // Write to a temporary file first so that concurrent runners never
+    // observe a partially written store.
+    auto path = std::filesystem::path{store_file_};
+    auto ec   = std::error_code{};
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto temp  = path;
+    temp      += fmt::format(".{}.tmp", ::getpid());
+    {
+      auto file = std::ofstream{temp};
+      if (!file.is_open()) {
+        spdlog::error("failed to save version cache to {}", store_file_);
+        return;
+      }
+      file << store.dump();
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+      spdlog::error("failed to save version cache to {}: {}", store_file_, ec.message());
+    }
+  }
+
+} // namespace lint
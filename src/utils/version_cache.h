@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace lint {
+  /// Run `<binary> --version` and return its stdout, or std::nullopt if it
+  /// fails.
+  auto probe_version(const std::string &binary) -> std::optional<std::string>;
+
+  /// Outputs of `<binary> --version` of previous runs, persisted as a small
+  /// json file. An entry is keyed by the resolved path of the binary, and it's
+  /// only reused while the inode, mtime and size of the binary are unchanged.
+  class version_cache {
+  public:
+    /// Load entries from the store file. A missing or broken store file is
+    /// treated as empty. An empty store file name keeps entries in memory only.
+    explicit version_cache(std::string store_file);
+
+    /// Return the output of `<binary> --version`. The binary only runs if it
+    /// isn't probed before. Failed probes aren't cached. Thread safe.
+    auto probe(const std::string &binary) -> std::optional<std::string>;
+
+    /// Write entries back to the store file if any entry is probed in this
+    /// run.
+    void save() const;
+
+  private:
+    struct entry {
+      std::uint64_t inode = 0;
+      std::uint64_t mtime = 0;
+      std::uint64_t size  = 0;
+      std::string output;
+    };
+
+    std::string store_file_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, entry> entries_;
+    bool modified_ = false;
+  };
+
+} // namespace lint
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/base_creator.h"
+#include "tools/base_tool.h"
+#include "tools/util.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+using namespace lint::tool;
+
+namespace {
+  struct fake_result : per_file_result_base { };
+
+  // A tool whose jobs fail when the job index is contained in `failed_jobs`.
+  struct fake_tool : tool_base {
+    explicit fake_tool(std::size_t num_jobs, std::size_t limit = 0, bool fastly = false)
+      : num_jobs(num_jobs)
+      , limit(limit)
+      , fastly(fastly) {
+    }
+
+    bool is_supported(operating_system_t /*system*/, arch_t /*arch*/) override {
+      return true;
+    }
+
+    auto name() -> std::string_view override {
+      return "fake";
+    }
+
+    auto version() -> std::string_view override {
+      return "1.0.0";
+    }
+
+    auto binary() -> std::string_view override {
+      return "fake";
+    }
+
+    auto prepare(const runtime_context & /*context*/) -> std::size_t override {
+      results = std::vector<std::optional<fake_result>>(num_jobs);
+      return num_jobs;
+    }
+
+    auto run_job(const runtime_context & /*context*/, std::size_t job) -> bool override {
+      auto now        = ++running;
+      auto max_before = max_running.load();
+      while (now > max_before && !max_running.compare_exchange_weak(max_before, now)) { }
+
+      auto res        = fake_result{};
+      res.file_path   = std::to_string(job);
+      res.file_option = res.file_path;
+      res.passed      = !ranges::contains(failed_jobs, job);
+      results[job]    = res;
+      --running;
+      return res.passed;
+    }
+
+    void finish(const runtime_context & /*context*/) override {
+      merge_results(result, results, fastly, "fake", "fake");
+      finished = true;
+    }
+
+    auto max_jobs() -> std::size_t override {
+      return limit;
+    }
+
+    auto fastly_exit() -> bool override {
+      return fastly;
+    }
+
+    void cancel() override {
+      ++cancelled;
+    }
+
+    auto get_reporter() -> reporter_base_ptr override {
+      return nullptr;
+    }
+
+    std::size_t num_jobs;
+    std::size_t limit;
+    bool fastly;
+    bool finished = false;
+    std::vector<std::size_t> failed_jobs;
+    std::atomic<std::size_t> running{0};
+    std::atomic<std::size_t> max_running{0};
+    std::atomic<std::size_t> cancelled{0};
+    std::vector<std::optional<fake_result>> results;
+    multi_files_result_base<fake_result> result;
+  };
+
+  // A creator of fake tools which checks files matched by `iregex`.
+  struct fake_creator : creator_base {
+    fake_creator(std::string name, std::string iregex)
+      : tool(std::move(name))
+      , iregex(std::move(iregex)) {
+    }
+
+    void register_option(program_options::options_description & /*desc*/) const override {
+    }
+
+    [[nodiscard]] auto name() const -> std::string_view override {
+      return tool;
+    }
+
+    [[nodiscard]] auto is_enabled(const program_options::variables_map & /*variables*/) const
+      -> bool override {
+      return true;
+    }
+
+    [[nodiscard]] auto file_filter(const program_options::variables_map & /*variables*/) const
+      -> std::string override {
+      return iregex;
+    }
+
+    auto create_tool(const program_options::variables_map & /*variables*/)
+      -> tool_base_ptr override {
+      ++created;
+      return std::make_unique<fake_tool>(1);
+    }
+
+    std::string tool;
+    std::string iregex;
+    std::size_t created = 0;
+  };
+} // namespace
+
+TEST_CASE("Test job graph runs all jobs of all tools", "[cpp-lint-action][tools][scheduler]") {
+  auto context = runtime_context{};
+  context.jobs = 4;
+
+  auto tool1 = fake_tool{20};
+  auto tool2 = fake_tool{7};
+  run_job_graph({&tool1, &tool2}, context);
+
+  REQUIRE(tool1.finished);
+  REQUIRE(tool2.finished);
+  REQUIRE(tool1.result.final_passed);
+  REQUIRE(tool1.result.passes.size() == 20);
+  REQUIRE(tool2.result.passes.size() == 7);
+}
+
+TEST_CASE("Test job graph respects per-tool limits", "[cpp-lint-action][tools][scheduler]") {
+  auto context = runtime_context{};
+  context.jobs = 8;
+
+  auto tool = fake_tool{50, 2};
+  run_job_graph({&tool}, context);
+  REQUIRE(tool.result.passes.size() == 50);
+  REQUIRE(tool.max_running <= 2);
+}
+
+TEST_CASE("Test job graph cancels remaining jobs of a fastly exited tool",
+          "[cpp-lint-action][tools][scheduler]") {
+  auto context = runtime_context{};
+  context.jobs = 1;
+
+  auto tool1        = fake_tool{10, 0, true};
+  tool1.failed_jobs = {2};
+  auto tool2        = fake_tool{5};
+  run_job_graph({&tool1, &tool2}, context);
+
+  REQUIRE(tool1.result.fastly_exited);
+  REQUIRE(tool1.result.final_passed == false);
+  REQUIRE(tool1.result.passes.size() == 2);
+  REQUIRE(tool1.result.fails.size() == 1);
+  REQUIRE(tool1.cancelled == 1);
+
+  // Other tools aren't affected.
+  REQUIRE(tool2.result.passes.size() == 5);
+  REQUIRE(tool2.cancelled == 0);
+}
+
+TEST_CASE("Test merge results keeps failed commands in job order",
+          "[cpp-lint-action][tools][scheduler]") {
+  auto context = runtime_context{};
+  context.jobs = 3;
+
+  auto tool        = fake_tool{6};
+  tool.failed_jobs = {4, 1};
+  tool.check(context);
+
+  REQUIRE(tool.result.final_passed == false);
+  REQUIRE(tool.result.fails.size() == 2);
+  REQUIRE(tool.result.failed_commands == std::vector<std::string>{"fake 1", "fake 4"});
+}
+
+TEST_CASE("Test tools without files to check are skipped before creation",
+          "[cpp-lint-action][tools][creator]") {
+  auto context          = runtime_context{};
+  context.jobs          = 2;
+  context.changed_files = {"README.md", "src/main.cpp", "src/old.h"};
+
+  context.deltas["README.md"].status    = GIT_DELTA_MODIFIED;
+  context.deltas["src/main.cpp"].status = GIT_DELTA_MODIFIED;
+  context.deltas["src/old.h"].status    = GIT_DELTA_DELETED;
+
+  auto creators = std::vector<creator_base_ptr>{};
+  creators.push_back(std::make_unique<fake_creator>("header-tool", R"(.*\.h)"));
+  creators.push_back(std::make_unique<fake_creator>("cpp-tool", R"(.*\.cpp)"));
+  auto variables = program_options::variables_map{};
+
+  auto slots = create_enabled_tools(creators, variables, context);
+  REQUIRE(slots.size() == 2);
+  REQUIRE(dynamic_cast<fake_creator &>(*creators[1]).created == 1);
+
+  // Deleted files are never checked, so the header tool isn't even created.
+  REQUIRE(dynamic_cast<fake_creator &>(*creators[0]).created == 0);
+  REQUIRE(slots[0].tool == nullptr);
+  REQUIRE(slots[0].skipped->tool_name() == "header-tool");
+  REQUIRE(slots[0].skipped->is_skipped());
+  REQUIRE(std::get<0>(slots[0].skipped->get_brief_result()));
+  REQUIRE(slots[1].tool != nullptr);
+
+  // Reporters keep the order of creators.
+  auto reporters = run_tools(slots, context);
+  REQUIRE(reporters.size() == 2);
+  REQUIRE(reporters[0]->tool_name() == "header-tool");
+  REQUIRE(reporters[1] == nullptr); // Reporter of the fake tool.
+  REQUIRE(dynamic_cast<fake_tool &>(*slots[1].tool).finished);
+}
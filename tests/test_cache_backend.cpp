@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/backend.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "cache/result_cache.h"
+#include "cache/server.h"
+
+using namespace lint;
+
+namespace {
+  const auto work_dir = std::filesystem::temp_directory_path() / "test_cache_backend";
+  const auto key      = std::string{"0123456789abcdef0123456789abcdef01234567"};
+
+  auto key_of(int number) -> std::string {
+    return fmt::format("{:040x}", number);
+  }
+
+  // Run a cache server on a free port of localhost until destroyed.
+  struct running_server {
+    explicit running_server(const std::string &token, std::uint64_t max_size = 0)
+      : server((work_dir / "server").string(), token, max_size) {
+      port   = server.bind("127.0.0.1", 0);
+      thread = std::thread{[this] { server.serve(); }};
+      while (port > 0 && !server.is_running()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+    }
+
+    ~running_server() {
+      server.stop();
+      thread.join();
+    }
+
+    [[nodiscard]] auto url() const -> std::string {
+      return fmt::format("http://127.0.0.1:{}/cache", port);
+    }
+
+    cache::cache_server server;
+    int port = -1;
+    std::thread thread;
+  };
+} // namespace
+
+TEST_CASE("Test cache keys are validated", "[cpp-lint-action][cache_backend]") {
+  REQUIRE(cache::is_valid_key(key));
+  REQUIRE_FALSE(cache::is_valid_key(""));
+  REQUIRE_FALSE(cache::is_valid_key("../etc/passwd"));
+  REQUIRE_FALSE(cache::is_valid_key("0123ABCD"));
+}
+
+TEST_CASE("Test http cache backend", "[cpp-lint-action][cache_backend]") {
+  std::filesystem::remove_all(work_dir);
+  auto server = running_server{"secret"};
+  REQUIRE(server.port > 0);
+
+  SECTION("Stored entries are returned") {
+    auto backend = cache::http_backend{server.url(), "secret"};
+    REQUIRE(backend.get(key) == std::nullopt);
+    backend.put(key, R"({"passed":true})");
+    REQUIRE(backend.get(key) == R"({"passed":true})");
+  }
+
+  SECTION("Requests without the token are rejected") {
+    cache::http_backend{server.url(), "secret"}.put(key, "{}");
+    auto backend = cache::http_backend{server.url(), "wrong"};
+    REQUIRE(backend.get(key) == std::nullopt);
+  }
+
+  SECTION("Remote hits are copied into the local directory") {
+    cache::http_backend{server.url(), "secret"}.put(key, R"({"passed":true})");
+
+    auto backends = std::vector<cache::backend_base_ptr>{};
+    backends.push_back(std::make_unique<cache::directory_backend>((work_dir / "local").string()));
+    backends.push_back(std::make_unique<cache::http_backend>(server.url(), "secret"));
+    auto results = cache::result_cache{std::move(backends)};
+    REQUIRE(results.get(key) == nlohmann::json{{"passed", true}});
+
+    auto local = cache::result_cache{(work_dir / "local").string()};
+    REQUIRE(local.get(key) == nlohmann::json{{"passed", true}});
+  }
+
+  std::filesystem::remove_all(work_dir);
+}
+
+TEST_CASE("Test cache server limits its exposure", "[cpp-lint-action][cache_backend]") {
+  std::filesystem::remove_all(work_dir);
+
+  SECTION("Only loopback addresses are allowed without a token") {
+    REQUIRE(cache::is_loopback("127.0.0.1"));
+    REQUIRE(cache::is_loopback("localhost"));
+    REQUIRE(cache::is_loopback("::1"));
+    REQUIRE_FALSE(cache::is_loopback("0.0.0.0"));
+    REQUIRE_FALSE(cache::is_loopback("192.168.1.2"));
+
+    auto server = cache::cache_server{(work_dir / "server").string(), "", 0};
+    REQUIRE(server.bind("0.0.0.0", 0) == -1);
+  }
+
+  SECTION("Least recently used entries are evicted beyond the size cap") {
+    auto server  = running_server{"secret", 10 * 1024};
+    auto backend = cache::http_backend{server.url(), "secret"};
+    auto value   = std::string(1000, 'x');
+    for (int i = 0; i < 20; ++i) {
+      backend.put(key_of(i), value);
+    }
+    auto kept = 0;
+    for (int i = 0; i < 20; ++i) {
+      kept += backend.get(key_of(i)) ? 1 : 0;
+    }
+    REQUIRE(kept > 0);
+    REQUIRE(kept < 20);
+  }
+
+  std::filesystem::remove_all(work_dir);
+}
+
+TEST_CASE("Test unreachable http cache backend", "[cpp-lint-action][cache_backend]") {
+  // Nothing listens on the discard port of localhost.
+  auto backend = cache::http_backend{"http://127.0.0.1:9", ""};
+  REQUIRE(backend.get(key) == std::nullopt);
+  backend.put(key, "{}");
+  REQUIRE(backend.get(key) == std::nullopt);
+}
@@ -21,6 +21,9 @@
 #include "tools/clang_format/clang_format.h"
 #include "tools/clang_format/general/impl.h"
 #include "tools/clang_format/general/reporter.h"
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+#  include "tools/clang_format/libformat/impl.h"
+#endif
 #include "tools/util.h"
 #include "utils/shell.h"
 
@@ -130,6 +133,11 @@ TEST_CASE("Test register and create clang-format option",
     REQUIRE_THROWS(creator->create_option(opts));
   }
 
+  SECTION("Receive an unsupported clang-format engine should throw exception") {
+    auto opts = parse_opt(desc, "--target-revision=main", "--clang-format-engine=invalid");
+    REQUIRE_THROWS(creator->create_option(opts));
+  }
+
   SECTION("Receive an invalid clang-format binary should throw exception") {
     auto opts = parse_opt(desc,
                           "--target-revision=main",
@@ -194,12 +202,14 @@ namespace {
     return clang_format::clang_format_general{option};
   }
 
-  auto create_runtime_context(const std::string &target, const std::string &source)
-    -> runtime_context {
-    auto context      = runtime_context{};
-    context.repo_path = get_temp_repo_dir();
-    context.target    = target;
-    context.source    = source;
+  auto create_runtime_context(const std::string &target,
+                              const std::string &source,
+                              std::uint16_t rename_threshold = 0) -> runtime_context {
+    auto context             = runtime_context{};
+    context.repo_path        = get_temp_repo_dir();
+    context.target           = target;
+    context.source           = source;
+    context.rename_threshold = rename_threshold;
     fill_git_info(context);
     return context;
   }
@@ -468,6 +478,168 @@ TEST_CASE("Test clang-format could correctly check basic unformatted error",
   }
 }
 
+TEST_CASE("Test clang-format batch mode splits replacements to files",
+          "[cpp-lint-action][tool][clang_format][general_version]") {
+  SKIP_IF_NO_CLANG_FORMAT
+  auto clang_format              = create_clang_format();
+  clang_format.option.batch_size = 3;
+
+  auto repo = repo_t{};
+  repo.commit_clang_format();
+  repo.add_file("test1.cpp", "int n = 1;\n");
+  auto target = repo.commit_changes();
+
+  repo.add_file("test2.cpp", "int n    = 1;\n");
+  repo.add_file("test3.cpp", "int n = 1;\n");
+  repo.add_file("test4.cpp", "int n = 1;\n");
+  repo.add_file("test5.cpp", "int n =   1;\nint m = 2;\n");
+  auto source = repo.commit_changes();
+
+  auto context = create_runtime_context(target, source);
+  clang_format.check(context);
+  check_result(clang_format, false, 2, 2, 0);
+
+  const auto &result = clang_format.result;
+  REQUIRE(result.fails.at("test2.cpp").replacements.size() == 1);
+  REQUIRE(result.fails.at("test5.cpp").replacements.contains(1));
+  REQUIRE(result.passes.at("test3.cpp").replacements.empty());
+  REQUIRE(result.failed_commands.size() == 2);
+  REQUIRE(result.failed_commands[1] == "clang-format --output-replacements-xml test5.cpp");
+}
+
+TEST_CASE("Test clang-format reuses results of files moved without changes",
+          "[cpp-lint-action][tool][clang_format][general_version]") {
+  SKIP_IF_NO_CLANG_FORMAT
+  const auto cache_dir = std::filesystem::temp_directory_path() / "test_clang_format_moved";
+  std::filesystem::remove_all(cache_dir);
+
+  auto repo = repo_t{};
+  repo.commit_clang_format();
+  auto base = repo.commit_changes();
+  std::filesystem::create_directories(repo.get_path() / "old");
+  std::filesystem::create_directories(repo.get_path() / "new");
+  repo.add_file("old/test.cpp", "int n    = 1;\n");
+  auto target = repo.commit_changes();
+
+  auto first        = create_clang_format();
+  auto context      = create_runtime_context(base, target);
+  context.cache_dir = cache_dir.string();
+  first.check(context);
+  REQUIRE(first.result.cache_misses == 1);
+
+  repo.remove_file("old/test.cpp");
+  repo.add_file("new/test.cpp", "int n    = 1;\n");
+  auto source = repo.commit_changes();
+
+  // Rename detection is opt-in.
+  auto added_context = create_runtime_context(target, source);
+  REQUIRE(added_context.deltas.at("new/test.cpp").status == GIT_DELTA_ADDED);
+
+  auto second             = create_clang_format();
+  auto moved_context      = create_runtime_context(target, source, 50);
+  moved_context.cache_dir = cache_dir.string();
+  REQUIRE(moved_context.deltas.at("new/test.cpp").status == GIT_DELTA_RENAMED);
+  second.check(moved_context);
+  check_result(second, false, 0, 1, 0);
+  REQUIRE(second.result.cache_hits == 1);
+  REQUIRE(second.result.fails.at("new/test.cpp").replacements.size() == 1);
+  REQUIRE(second.result.failed_commands[0]
+          == "clang-format --output-replacements-xml new/test.cpp");
+  std::filesystem::remove_all(cache_dir);
+}
+
+TEST_CASE("Test clang-format cache keys cover parent configs",
+          "[cpp-lint-action][tool][clang_format][general_version]") {
+  SKIP_IF_NO_CLANG_FORMAT
+  const auto cache_dir = std::filesystem::temp_directory_path() / "test_clang_format_parent";
+  std::filesystem::remove_all(cache_dir);
+
+  auto repo = repo_t{};
+  repo.commit_clang_format();
+  std::filesystem::create_directories(repo.get_path() / "sub");
+  repo.add_file("sub/.clang-format", "InheritParentConfig: true\n");
+  auto target = repo.commit_changes();
+  repo.add_file("sub/test.cpp", "int n = 1;\n");
+  auto source = repo.commit_changes();
+
+  auto check = [&] {
+    auto clang_format = create_clang_format();
+    auto context      = create_runtime_context(target, source);
+    context.cache_dir = cache_dir.string();
+    clang_format.check(context);
+    return clang_format.result.cache_hits;
+  };
+  REQUIRE(check() == 0);
+  REQUIRE(check() == 1);
+
+  // The nearest config is unchanged, but it inherits the edited parent.
+  repo.add_file(".clang-format", "BasedOnStyle: LLVM\n");
+  REQUIRE(check() == 0);
+  REQUIRE(check() == 1);
+
+  repo.add_file(".clang-format-ignore", "sub/*.cpp\n");
+  REQUIRE(check() == 0);
+  std::filesystem::remove_all(cache_dir);
+}
+
+TEST_CASE("Test clang-format doesn't cache results of failed runs",
+          "[cpp-lint-action][tool][clang_format][general_version]") {
+  SKIP_IF_NO_CLANG_FORMAT
+  const auto cache_dir = std::filesystem::temp_directory_path() / "test_clang_format_failed";
+  std::filesystem::remove_all(cache_dir);
+
+  auto repo = repo_t{};
+  repo.add_file(".clang-format", "BasedOnStyle: NoSuchStyle\n");
+  auto target = repo.commit_changes();
+  repo.add_file("test.cpp", "int n = 1;\n");
+  auto source = repo.commit_changes();
+
+  for (auto run = 0; run < 2; ++run) {
+    auto clang_format = create_clang_format();
+    auto context      = create_runtime_context(target, source);
+    context.cache_dir = cache_dir.string();
+    clang_format.check(context);
+    check_result(clang_format, false, 0, 1, 0);
+    REQUIRE(clang_format.result.cache_hits == 0);
+    REQUIRE(clang_format.result.cache_misses == 1);
+  }
+  std::filesystem::remove_all(cache_dir);
+}
+
+#ifdef CPP_LINT_ACTION_WITH_LIBFORMAT
+TEST_CASE("Test libformat engine gets the same result as clang-format process",
+          "[cpp-lint-action][tool][clang_format][libformat]") {
+  SKIP_IF_NO_CLANG_FORMAT
+  auto process   = create_clang_format();
+  auto option    = clang_format::option_t{};
+  option.enabled = true;
+  option.binary  = "clang-format";
+  auto libformat = clang_format::clang_format_libformat{option};
+
+  auto repo = repo_t{};
+  repo.commit_clang_format();
+  repo.add_file("test1.cpp", "int n = 1;\n");
+  auto target = repo.commit_changes();
+
+  repo.add_file("test2.cpp", "int n    = 1;\n");
+  repo.add_file("test3.cpp", "int n = 1;\n");
+  repo.add_file("test4.cpp", "#include <vector>\n#include <array>\nint m =   2;\n");
+  auto source = repo.commit_changes();
+
+  auto context = create_runtime_context(target, source);
+  process.check(context);
+  libformat.check(context);
+  check_result(libformat, false, 1, 2, 0);
+  for (const auto &[file, expected]: process.result.fails) {
+    const auto &replacements = libformat.result.fails.at(file).replacements;
+    REQUIRE(replacements.size() == expected.replacements.size());
+    for (const auto &[row, expected_row]: expected.replacements) {
+      REQUIRE(replacements.at(row).size() == expected_row.size());
+    }
+  }
+}
+#endif
+
 TEST_CASE("Test parse replacements", "[cpp-lint-action][tool][clang_format][general_version]") {
   SKIP_IF_NO_CLANG_FORMAT
 
@@ -19,6 +19,7 @@
 #include "test_common.h"
 #include "tools/base_tool.h"
 #include "tools/clang_tidy/clang_tidy.h"
+#include "tools/clang_tidy/clangd/impl.h"
 #include "tools/clang_tidy/general/impl.h"
 #include "tools/clang_tidy/general/reporter.h"
 #include "tools/util.h"
@@ -466,6 +467,211 @@ TEST_CASE("Test clang-tidy could correctly check basic error",
   }
 }
 
+namespace {
+  // A stub of clang-tidy which reports an error for each file containing
+  // "bad", using the absolute path just as clang-tidy does. Files containing
+  // "header" or "broken" report a warning or an error of a header instead.
+  // The files of each run are appended to "<stub>.log".
+  auto create_stub_clang_tidy() -> std::string {
+    auto stub = std::filesystem::temp_directory_path() / "stub-clang-tidy";
+    auto file = std::ofstream{stub};
+    file << "#!/bin/sh\n"
+            "status=0\n"
+            "for f in \"$@\"; do\n"
+            "  case \"$f\" in -*) continue ;; esac\n"
+            "  files=\"$files $f\"\n"
+            "  if grep -q bad \"$f\"; then\n"
+            "    echo \"$(pwd)/$f:1:1: error: bad content [stub-check]\"\n"
+            "    echo \"bad\"\n"
+            "    status=1\n"
+            "  fi\n"
+            "  if grep -q header \"$f\"; then\n"
+            "    echo \"$(pwd)/header.h:1:1: warning: bad header [stub-check]\"\n"
+            "  fi\n"
+            "  if grep -q broken \"$f\"; then\n"
+            "    echo \"$(pwd)/broken.h:1:1: error: broken header [stub-check]\"\n"
+            "    status=1\n"
+            "  fi\n"
+            "done\n"
+            "echo \"$files\" >> \"$0.log\"\n"
+            "echo \"$# files checked\" >&2\n"
+            "exit $status\n";
+    file.close();
+    std::filesystem::permissions(stub, std::filesystem::perms::owner_all);
+    return stub.string();
+  }
+} // namespace
+
+TEST_CASE("Test clang-tidy batch mode routes diagnostics to files",
+          "[cpp-lint-action][tool][clang_tidy][general_version]") {
+  auto option       = clang_tidy::option_t{};
+  option.enabled    = true;
+  option.binary     = create_stub_clang_tidy();
+  option.batch_size = 2;
+  auto clang_tidy   = clang_tidy::clang_tidy_general{option};
+
+  auto repo = repo_t{};
+  repo.add_file("test1.cpp", "good\n");
+  auto target = repo.commit_changes();
+
+  repo.add_file("test2.cpp", "bad\n");
+  repo.add_file("test3.cpp", "good\n");
+  repo.add_file("test4.cpp", "good\n");
+  repo.add_file("test5.cpp", "bad\n");
+  auto source = repo.commit_changes();
+
+  auto context = create_runtime_context(target, source);
+  clang_tidy.check(context);
+  check_result(clang_tidy, false, 2, 2, 0);
+
+  const auto &result = clang_tidy.result;
+  REQUIRE(result.fails.at("test2.cpp").diags.size() == 1);
+  REQUIRE(result.fails.at("test5.cpp").diags.size() == 1);
+  REQUIRE(result.passes.at("test3.cpp").diags.empty());
+  REQUIRE(result.failed_commands.size() == 2);
+  REQUIRE(result.failed_commands[0] == "clang-tidy test2.cpp");
+  REQUIRE(result.failed_commands[1] == "clang-tidy test5.cpp");
+
+  // Each file keeps only the output of its own diagnostics.
+  auto root = repo.get_path().string();
+  REQUIRE(result.fails.at("test2.cpp").tool_stdout
+          == root + "/test2.cpp:1:1: error: bad content [stub-check]\nbad\n");
+  REQUIRE(result.passes.at("test3.cpp").tool_stdout.empty());
+}
+
+TEST_CASE("Test clang-tidy batch mode handles header diagnostics",
+          "[cpp-lint-action][tool][clang_tidy][general_version]") {
+  auto option       = clang_tidy::option_t{};
+  option.enabled    = true;
+  option.binary     = create_stub_clang_tidy();
+  option.batch_size = 4;
+  auto log          = option.binary + ".log";
+  std::filesystem::remove(log);
+  auto runs = [&] {
+    auto file  = std::ifstream{log};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(file, line);) {
+      lines.push_back(line);
+    }
+    return lines;
+  };
+
+  auto repo = repo_t{};
+  repo.add_file("test1.cpp", "good\n");
+  auto target = repo.commit_changes();
+
+  repo.add_file("test2.cpp", "good\n");
+  repo.add_file("test3.cpp", "header\n");
+  repo.add_file("test4.cpp", "bad\n");
+  auto source = repo.commit_changes();
+
+  SECTION("Warnings of headers are dropped in a batch") {
+    auto clang_tidy = clang_tidy::clang_tidy_general{option};
+    clang_tidy.check(create_runtime_context(target, source));
+    check_result(clang_tidy, false, 2, 1, 0);
+
+    const auto &result = clang_tidy.result;
+    REQUIRE(result.passes.at("test3.cpp").diags.empty());
+    REQUIRE(result.fails.at("test4.cpp").diags.size() == 1);
+    REQUIRE(runs() == std::vector<std::string>{" test2.cpp test3.cpp test4.cpp"});
+  }
+
+  SECTION("A header filter disables batches") {
+    option.header_filter = ".*";
+    auto clang_tidy      = clang_tidy::clang_tidy_general{option};
+    clang_tidy.check(create_runtime_context(target, source));
+    check_result(clang_tidy, false, 2, 1, 0);
+
+    const auto &diags = clang_tidy.result.passes.at("test3.cpp").diags;
+    REQUIRE(diags.size() == 1);
+    REQUIRE(diags[0].header.file_name.ends_with("/header.h"));
+    REQUIRE(runs().size() == 3);
+  }
+
+  SECTION("Only files without errors of their own are checked again for header errors") {
+    repo.add_file("test5.cpp", "broken\n");
+    auto broken     = repo.commit_changes();
+    auto clang_tidy = clang_tidy::clang_tidy_general{option};
+    clang_tidy.check(create_runtime_context(target, broken));
+    check_result(clang_tidy, false, 2, 2, 0);
+
+    const auto &result = clang_tidy.result;
+    REQUIRE(result.fails.at("test4.cpp").diags.size() == 1);
+    REQUIRE(result.fails.at("test5.cpp").diags.size() == 1);
+    REQUIRE(result.fails.at("test5.cpp").diags[0].header.file_name.ends_with("/broken.h"));
+    REQUIRE(
+      runs()
+      == std::vector<std::string>{
+        " test2.cpp test3.cpp test4.cpp test5.cpp",
+        " test2.cpp",
+        " test3.cpp",
+        " test5.cpp"});
+  }
+}
+
+TEST_CASE("Test clangd diagnostics are mapped to clang-tidy diagnostics",
+          "[cpp-lint-action][tool][clang_tidy][clangd]") {
+  auto params = nlohmann::json::parse(R"({
+    "uri": "file:///repo/main.cpp",
+    "diagnostics": [
+      {"range": {"start": {"line": 0, "character": 4}, "end": {"line": 0, "character": 5}},
+       "severity": 2, "source": "clang-tidy", "code": "bugprone-use-after-move",
+       "message": "'x' used after it was moved"},
+      {"range": {"start": {"line": 9, "character": 0}, "end": {"line": 9, "character": 3}},
+       "severity": 1, "source": "clang", "code": "undeclared_var_use",
+       "message": "use of undeclared identifier 'y'"},
+      {"range": {"start": {"line": 2, "character": 1}, "end": {"line": 2, "character": 1}},
+       "severity": 3, "source": "clang", "message": "declared here"}
+    ]
+  })");
+  const auto &lsp_diags = params.at("diagnostics");
+
+  // LSP positions are 0-based, while clang-tidy prints 1-based ones.
+  auto tidy = clang_tidy::to_diagnostic("/repo/main.cpp", lsp_diags[0]);
+  REQUIRE(tidy.header.file_name == "/repo/main.cpp");
+  REQUIRE(tidy.header.row_idx == "1");
+  REQUIRE(tidy.header.col_idx == "5");
+  REQUIRE(tidy.header.serverity == "warning");
+  REQUIRE(tidy.header.brief == " 'x' used after it was moved ");
+  REQUIRE(tidy.header.checks == "bugprone-use-after-move");
+
+  auto compiler = clang_tidy::to_diagnostic("/repo/main.cpp", lsp_diags[1]);
+  REQUIRE(compiler.header.row_idx == "10");
+  REQUIRE(compiler.header.col_idx == "1");
+  REQUIRE(compiler.header.serverity == "error");
+  REQUIRE(compiler.header.checks == "clang-diagnostic-undeclared_var_use");
+
+  auto note = clang_tidy::to_diagnostic("/repo/main.cpp", lsp_diags[2]);
+  REQUIRE(note.header.serverity == "info");
+  REQUIRE(note.header.checks == "clang-diagnostic-info");
+}
+
+TEST_CASE("Test clangd takes a job for each of its workers",
+          "[cpp-lint-action][tool][clang_tidy][clangd]") {
+  auto option          = clang_tidy::option_t{};
+  option.enabled       = true;
+  option.clangd_binary = "clangd";
+
+  auto repo = repo_t{};
+  repo.add_file("test1.cpp", "int a;\n");
+  auto target = repo.commit_changes();
+  repo.add_file("test2.cpp", "int b;\n");
+  repo.add_file("test3.cpp", "int c;\n");
+  repo.add_file("test4.cpp", "int d;\n");
+  auto source = repo.commit_changes();
+
+  auto context = create_runtime_context(target, source);
+  context.jobs = 2;
+  REQUIRE(clang_tidy::clang_tidy_clangd{option}.prepare(context) == 2);
+
+  // Never more workers than files.
+  context.jobs = 8;
+  REQUIRE(clang_tidy::clang_tidy_clangd{option}.prepare(context) == 3);
+
+  option.max_jobs = 1;
+  REQUIRE(clang_tidy::clang_tidy_clangd{option}.prepare(context) == 1);
+}
+
 TEST_CASE("Test reporter", "[cpp-lint-action][tool][clang_tidy][general_version]") {
   auto option = clang_tidy::option_t{};
   auto result = clang_tidy::result_t{};
@@ -23,6 +23,7 @@
 #include <git2/diff.h>
 #include <spdlog/spdlog.h>
 
+#include "utils/common.h"
 #include "utils/git_utils.h"
 
 using namespace lint; // NOLINT
@@ -170,23 +171,4 @@ void append_content_to_file(const std::string &file, const std::string &content)
 // Initialize a basic repo for futhure test.
 auto init_basic_repo() -> lint::git::repo_ptr;
 
-class scope_guard {
-public:
-  explicit scope_guard(std::function<void()> f)
-    : func_(std::move(f)) {
-  }
-
-  ~scope_guard() {
-    if (func_) {
-      func_();
-    }
-  }
-
-  scope_guard(const scope_guard &)            = delete;
-  scope_guard &operator=(const scope_guard &) = delete;
-  scope_guard(scope_guard &&)                 = delete;
-  scope_guard &operator=(scope_guard &&)      = delete;
-
-private:
-  std::function<void()> func_;
-};
+using lint::scope_guard;
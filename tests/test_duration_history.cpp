@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/duration_history.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+namespace {
+  const auto store_dir  = std::filesystem::temp_directory_path() / "test_duration_history";
+  const auto store_file = (store_dir / "durations.json").string();
+} // namespace
+
+TEST_CASE("Test duration history persists durations", "[cpp-lint-action][duration_history]") {
+  std::filesystem::remove_all(store_dir);
+
+  SECTION("A missing store file is treated as empty") {
+    auto history = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(history.lookup("main.cpp") == std::nullopt);
+  }
+
+  SECTION("Recorded durations are loaded by the same key") {
+    auto history = duration_history{store_file, "clang-tidy-18"};
+    history.record("main.cpp", 100);
+    history.save();
+
+    auto loaded = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(loaded.lookup("main.cpp") == 100);
+    auto other = duration_history{store_file, "clang-tidy-19"};
+    REQUIRE(other.lookup("main.cpp") == std::nullopt);
+  }
+
+  SECTION("Durations of other keys and files are kept when saving") {
+    auto first = duration_history{store_file, "clang-tidy-18"};
+    first.record("a.cpp", 10);
+    first.save();
+    auto second = duration_history{store_file, "clang-tidy-19"};
+    second.record("b.cpp", 20);
+    second.save();
+
+    auto loaded = duration_history{store_file, "clang-tidy-18"};
+    loaded.record("c.cpp", 30);
+    loaded.save();
+
+    auto reloaded = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(reloaded.lookup("a.cpp") == 10);
+    REQUIRE(reloaded.lookup("c.cpp") == 30);
+    REQUIRE(duration_history{store_file, "clang-tidy-19"}.lookup("b.cpp") == 20);
+  }
+
+  SECTION("A broken store file is treated as empty") {
+    std::filesystem::create_directories(store_dir);
+    std::ofstream{store_file} << "not a json";
+    auto history = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(history.lookup("main.cpp") == std::nullopt);
+    history.record("main.cpp", 5);
+    history.save();
+    REQUIRE(duration_history{store_file, "clang-tidy-18"}.lookup("main.cpp") == 5);
+  }
+
+  SECTION("A stored value of the key which isn't an object is treated as empty") {
+    std::filesystem::create_directories(store_dir);
+    std::ofstream{store_file} << R"({"clang-tidy-18": 5, "clang-tidy-19": {"a.cpp": 1}})";
+    auto history = duration_history{store_file, "clang-tidy-18"};
+    history.record("main.cpp", 5);
+    REQUIRE_NOTHROW(history.save());
+    REQUIRE(duration_history{store_file, "clang-tidy-18"}.lookup("main.cpp") == 5);
+    REQUIRE(duration_history{store_file, "clang-tidy-19"}.lookup("a.cpp") == 1);
+  }
+
+  SECTION("Files which aren't seen for long are pruned when saving") {
+    std::filesystem::create_directories(store_dir);
+    std::ofstream{store_file}
+      << R"({"clang-tidy-18": {"old.cpp": {"ms": 10, "seen": 0}, "legacy.cpp": 20}})";
+    auto history = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(history.lookup("old.cpp") == 10);
+    history.record("main.cpp", 30);
+    history.save();
+
+    auto loaded = duration_history{store_file, "clang-tidy-18"};
+    REQUIRE(loaded.lookup("old.cpp") == std::nullopt);
+    REQUIRE(loaded.lookup("legacy.cpp") == 20);
+    REQUIRE(loaded.lookup("main.cpp") == 30);
+  }
+
+  std::filesystem::remove_all(store_dir);
+}
@@ -23,8 +23,10 @@
 #include <catch2/catch_test_macros.hpp>
 #include <spdlog/spdlog.h>
 
+#include "context.h"
 #include "test_common.h"
 #include "utils/git_utils.h"
+#include "utils/pathspec.h"
 
 using namespace lint;
 using namespace std::string_literals;
@@ -215,6 +217,74 @@ TEST_CASE("Push two commits and get diff files", "[cpp-lint-action][git2][diff]"
   REQUIRE(changed_files.size() == 1);
 }
 
+TEST_CASE("Limit diff by pathspec", "[cpp-lint-action][git2][diff]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  create_temp_files({"file1.cpp"}, "hello world");
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, {"file1.cpp"});
+  auto commit1 = git::commit::lookup(*repo, git::commit::create_head(*repo, "Init", *index1));
+
+  const auto files = std::vector<std::string>{"file2.cpp", "file3.cpp", "readme.md"};
+  create_temp_files(files, "hello world");
+  auto [index_oid2, index2] = git::index::add_files(*repo, files);
+  auto commit2 = git::commit::lookup(*repo, git::commit::create_head(*repo, "Two", *index2));
+
+  auto pathspec = make_pathspec({"*.[cC][pP][pP]"}, {"file3.cpp"});
+  auto strings  = std::vector<char *>{};
+  for (auto &spec: pathspec) {
+    strings.push_back(spec.data());
+  }
+  auto opts             = git::diff::init_option();
+  opts.pathspec.strings = strings.data();
+  opts.pathspec.count   = strings.size();
+
+  auto diff   = git::diff::commit_to_commit(*repo, *commit1, *commit2, opts);
+  auto deltas = git::diff::deltas(*diff);
+  REQUIRE(deltas.size() == 1);
+  REQUIRE(deltas.contains("file2.cpp"));
+}
+
+TEST_CASE("Detect renamed files by find similar", "[cpp-lint-action][git2][diff]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  create_temp_files({"file1.cpp"}, "hello world");
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, {"file1.cpp"});
+  auto commit_oid1          = git::commit::create_head(*repo, "Init", *index1);
+  auto commit1              = git::commit::lookup(*repo, commit_oid1);
+
+  create_temp_files({"file2.cpp"}, "hello world");
+  git::index::add_files(*repo, {"file2.cpp"});
+  auto [index_oid2, index2] =
+    git::index::remove_files(*repo, get_temp_repo_dir().string(), {"file1.cpp"});
+  auto commit_oid2 = git::commit::create_head(*repo, "Rename", *index2);
+  auto commit2     = git::commit::lookup(*repo, commit_oid2);
+
+  SECTION("A rename is a deletion plus an addition by default") {
+    auto diff   = git::diff::get(*repo, *commit1, *commit2);
+    auto deltas = git::diff::deltas(*diff);
+    REQUIRE(deltas.size() == 2);
+    REQUIRE(deltas.at("file2.cpp").status == GIT_DELTA_ADDED);
+  }
+
+  SECTION("A rename is one delta if renames are found") {
+    auto opts   = git::diff::init_find_option();
+    opts.flags  = GIT_DIFF_FIND_RENAMES;
+    auto diff   = git::diff::get(*repo, *commit1, *commit2);
+    git::diff::find_similar(*diff, opts);
+    auto deltas = git::diff::deltas(*diff);
+    REQUIRE(deltas.size() == 1);
+    const auto &delta = deltas.at("file2.cpp");
+    REQUIRE(delta.status == GIT_DELTA_RENAMED);
+    REQUIRE(delta.similarity == 100);
+    REQUIRE(std::string{delta.old_file.path} == "file1.cpp");
+    REQUIRE(git::oid::equal(delta.old_file.id, delta.new_file.id));
+  }
+}
+
 TEST_CASE("Simple use of patch ", "[cpp-lint-action][git2][patch]") {
   create_temp_repo_dir();
   auto guard = scope_guard{remove_temp_repo_dir};
@@ -241,6 +311,30 @@ TEST_CASE("Simple use of patch ", "[cpp-lint-action][git2][patch]") {
   auto patch = git::patch::create_from_diff(*diff, 0);
 }
 
+TEST_CASE("Patch cache builds patches on demand", "[cpp-lint-action][git2][patch]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  const auto files = std::vector<std::string>{"file1.cpp", "file2.cpp"};
+  create_temp_files(files, "hello world");
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, files);
+  auto commit1 = git::commit::lookup(*repo, git::commit::create_head(*repo, "Init", *index1));
+
+  append_content_to_file("file1.cpp", "hello world2");
+  auto [index_oid2, index2] = git::index::add_files(*repo, {"file1.cpp"});
+  auto commit2 = git::commit::lookup(*repo, git::commit::create_head(*repo, "Two", *index2));
+
+  auto patches = patch_cache{git::diff::get(*repo, *commit1, *commit2)};
+  REQUIRE(patches.contains("file1.cpp"));
+  REQUIRE_FALSE(patches.contains("file2.cpp"));
+
+  auto &patch = patches.get("file1.cpp");
+  REQUIRE(git::patch::num_hunks(patch) == 1);
+  REQUIRE(&patches.get("file1.cpp") == &patch);
+  REQUIRE_THROWS(patches.get("file2.cpp"));
+}
+
 TEST_CASE("Create patch from buffers", "[cpp-lint-action][git2][patch]") {
   auto old_content = "int n = 2;"s;
   auto new_content = "double n = 2;"s;
@@ -264,6 +358,130 @@ TEST_CASE("Get file content from a specific commit", "[cpp-lint-action][git2][bl
   REQUIRE(content == "hello world");
 }
 
+TEST_CASE("View blob content without copying", "[cpp-lint-action][git2][blob]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  const auto content = "hello\0world"s;
+  std::filesystem::create_directory(get_temp_repo_dir() / "src");
+  create_temp_file("src/file1.cpp", content);
+  auto repo               = init_basic_repo();
+  auto [index_oid, index] = git::index::add_files(*repo, {"src/file1.cpp"});
+  auto commit = git::commit::lookup(*repo, git::commit::create_head(*repo, "Init", *index));
+  REQUIRE(git::blob::get_raw_content(*repo, *commit, "src/file1.cpp") == content);
+
+  auto files = tree_entry_cache{*repo, git::commit::tree(*commit)};
+  REQUIRE_FALSE(files.lookup("src").has_value());
+  REQUIRE_FALSE(files.read("src/file2.cpp").has_value());
+
+  auto view = files.read("src/file1.cpp");
+  REQUIRE(view.has_value());
+  REQUIRE(view->content() == content);
+  REQUIRE(git::oid::equal(view->id(), *files.lookup("src/file1.cpp")));
+}
+
+TEST_CASE("Write changed files from object database", "[cpp-lint-action][git2][blob]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  std::filesystem::create_directory(get_temp_repo_dir() / "src");
+  create_temp_file(".clang-format", "BasedOnStyle: Google");
+  create_temp_file("src/a.h", "int a();");
+  create_temp_file("src/unused.h", "int unused();");
+  create_temp_file("src/a.cpp", "#include \"a.h\"\n#include <vector>\n");
+  const auto files          = std::vector<std::string>{".clang-format", "src/a.h", "src/unused.h"};
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, files);
+  auto target               = git::oid::to_str(git::commit::create_head(*repo, "Init", *index1));
+  auto [index_oid2, index2] = git::index::add_files(*repo, {"src/a.cpp"});
+  auto source               = git::oid::to_str(git::commit::create_head(*repo, "Two", *index2));
+
+  // The working tree doesn't need to be on the source revision.
+  std::filesystem::remove(get_temp_repo_dir() / "src/a.cpp");
+
+  auto scratch        = get_temp_repo_dir() / "scratch";
+  auto context        = runtime_context{};
+  context.repo_path   = get_temp_repo_dir();
+  context.target      = target;
+  context.source      = source;
+  context.scratch_dir = scratch;
+  fill_git_info(context);
+  write_source_files(context);
+
+  auto dir = std::filesystem::path{context.work_dir()};
+  REQUIRE(dir.parent_path() == scratch);
+  REQUIRE(std::filesystem::exists(dir / "src/a.cpp"));
+  REQUIRE(std::filesystem::exists(dir / "src/a.h"));
+  REQUIRE(std::filesystem::exists(dir / ".clang-format"));
+  REQUIRE_FALSE(std::filesystem::exists(dir / "src/unused.h"));
+}
+
+TEST_CASE("Write included files found from include directories",
+          "[cpp-lint-action][git2][blob]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  std::filesystem::create_directories(get_temp_repo_dir() / "include/lib");
+  std::filesystem::create_directories(get_temp_repo_dir() / "src");
+  create_temp_file("include/lib/b.h", "int b();");
+  create_temp_file("include/c.h", "int c();");
+  create_temp_file("src/a.cpp", "#include <lib/b.h>\n#include \"c.h\"\n#include <vector>\n");
+  const auto files          = std::vector<std::string>{"include/lib/b.h", "include/c.h"};
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, files);
+  auto target               = git::oid::to_str(git::commit::create_head(*repo, "Init", *index1));
+  auto [index_oid2, index2] = git::index::add_files(*repo, {"src/a.cpp"});
+  auto source               = git::oid::to_str(git::commit::create_head(*repo, "Two", *index2));
+
+  auto context        = runtime_context{};
+  context.repo_path   = get_temp_repo_dir();
+  context.target      = target;
+  context.source      = source;
+  context.scratch_dir = get_temp_repo_dir() / "scratch";
+  fill_git_info(context);
+  write_source_files(context);
+
+  auto dir = std::filesystem::path{context.work_dir()};
+  REQUIRE(std::filesystem::exists(dir / "src/a.cpp"));
+  REQUIRE_FALSE(std::filesystem::exists(dir / "include/lib/b.h"));
+  REQUIRE_FALSE(std::filesystem::exists(dir / "include/c.h"));
+
+  REQUIRE(write_revision_files(context, {"src/a.cpp"}, {"include"}) == 3);
+  REQUIRE(std::filesystem::exists(dir / "include/lib/b.h"));
+  REQUIRE(std::filesystem::exists(dir / "include/c.h"));
+}
+
+TEST_CASE("Share snapshots of changed files", "[cpp-lint-action][git2][patch]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  const auto files = std::vector<std::string>{"file1.cpp", "file2.cpp"};
+  create_temp_files(files, "hello world\r\n");
+  auto repo                 = init_basic_repo();
+  auto [index_oid1, index1] = git::index::add_files(*repo, files);
+  auto target               = git::oid::to_str(git::commit::create_head(*repo, "Init", *index1));
+
+  append_content_to_file("file1.cpp", "hello world2");
+  auto [index_oid2, index2] = git::index::add_files(*repo, {"file1.cpp"});
+  auto source               = git::oid::to_str(git::commit::create_head(*repo, "Two", *index2));
+
+  auto context      = runtime_context{};
+  context.repo_path = get_temp_repo_dir();
+  context.target    = target;
+  context.source    = source;
+  fill_git_info(context);
+
+  const auto &snapshot = context.snapshot("file1.cpp");
+  REQUIRE(&context.snapshot("file1.cpp") == &snapshot);
+  REQUIRE(snapshot.status() == GIT_DELTA_MODIFIED);
+  REQUIRE(git_oid_equal(&snapshot.id(), &context.deltas.at("file1.cpp").new_file.id) != 0);
+  REQUIRE(snapshot.content() == "hello world\r\nhello world2");
+  REQUIRE(snapshot.lines().num_lines() == 2);
+  REQUIRE(snapshot.lines().position(13) == std::tuple{2, 1});
+  REQUIRE(snapshot.hunks(context.patches).position(2) == 2U);
+  REQUIRE_THROWS(context.snapshot("file2.cpp"));
+}
+
 TEST_CASE("Get lines in a hunk", "[cpp-lint-action][git2][patch]") {
   create_temp_repo_dir();
   auto guard = scope_guard{remove_temp_repo_dir};
@@ -289,6 +507,25 @@ TEST_CASE("Get lines in a hunk", "[cpp-lint-action][git2][patch]") {
   REQUIRE(contents[2] == "hello world3");
 }
 
+TEST_CASE("Map rows to diff positions by hunk index", "[cpp-lint-action][git2][patch]") {
+  auto old_content = ""s;
+  for (auto i = 1; i <= 20; ++i) {
+    old_content += fmt::format("line {}\n", i);
+  }
+  auto new_content = old_content;
+  new_content.replace(new_content.find("line 2\n"), 6, "line two");
+  new_content.replace(new_content.find("line 18\n"), 7, "line eighteen");
+
+  auto opt   = git::diff::init_option();
+  auto patch = git::patch::create_from_buffers(old_content, "a.cpp", new_content, "a.cpp", opt);
+  auto hunks = git::hunk_index{*patch};
+  REQUIRE(hunks.size() == 2);
+  REQUIRE(hunks.position(2) == 2U);
+  REQUIRE(hunks.position(18) == 10U);
+  REQUIRE(hunks.position(10) == std::nullopt);
+  REQUIRE(hunks.position(0) == std::nullopt);
+}
+
 TEST_CASE("Compare from buffer", "[cpp-lint-action][git2][patch]") {
   // Compare original content with formatted result of a file.
 
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/include_closure.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <nlohmann/json.hpp>
+
+using namespace lint;
+
+namespace {
+  const auto work_dir = std::filesystem::temp_directory_path() / "test_include_closure";
+} // namespace
+
+TEST_CASE("Test splitting compile commands", "[cpp-lint-action][include_closure]") {
+  using strings = std::vector<std::string>;
+  REQUIRE(cache::split_command("c++ -c  a.cpp") == strings{"c++", "-c", "a.cpp"});
+  REQUIRE(cache::split_command(R"(c++ "-DA=\"b c\"" 'd e' f\ g)")
+          == strings{"c++", R"(-DA="b c")", "d e", "f g"});
+  REQUIRE(cache::split_command(R"(c++ "")") == strings{"c++", ""});
+}
+
+TEST_CASE("Test parsing make rules", "[cpp-lint-action][include_closure]") {
+  using strings = std::vector<std::string>;
+  REQUIRE(cache::parse_make_rule("a.o: a.cpp a.h \\\n  /usr/include/b.h\n")
+          == strings{"a.cpp", "a.h", "/usr/include/b.h"});
+  REQUIRE(cache::parse_make_rule("a.o: dir\\ x/a.cpp $$c.h\nc.h:\n")
+          == strings{"dir x/a.cpp", "$c.h"});
+  REQUIRE(cache::parse_make_rule("a.o:").empty());
+}
+
+TEST_CASE("Test relocating compile commands", "[cpp-lint-action][include_closure]") {
+  using strings = std::vector<std::string>;
+  auto command  = cache::compile_command{};
+  command.directory = "/repo/build";
+  command.file      = "../src/a.cpp";
+  command.arguments = {"c++", "-I../include", "-isystem", "/repo/third_party", "-Igen", "-c",
+                       "../src/a.cpp", "-o", "a.o"};
+  REQUIRE(cache::include_dirs(command)
+          == strings{"/repo/include", "/repo/third_party", "/repo/build/gen"});
+
+  auto moved = cache::relocate(command, "/repo/", "/scratch", "/repo/build");
+  REQUIRE(moved.directory == "/repo/build");
+  REQUIRE(moved.file == "/scratch/src/a.cpp");
+  REQUIRE(moved.arguments
+          == strings{"c++", "-I/scratch/include", "-isystem", "/scratch/third_party",
+                     "-I/repo/build/gen", "-c", "/scratch/src/a.cpp", "-o", "a.o"});
+
+  command.directory = "/repo";
+  command.file      = "src/a.cpp";
+  command.arguments = {"c++", "-I", "include", "src/a.cpp"};
+  moved             = cache::relocate(command, "/repo", "/scratch", "/repo/build");
+  REQUIRE(moved.directory == "/scratch");
+  REQUIRE(moved.arguments == strings{"c++", "-I", "/scratch/include", "/scratch/src/a.cpp"});
+}
+
+TEST_CASE("Test include closures", "[cpp-lint-action][include_closure]") {
+  std::filesystem::remove_all(work_dir);
+  std::filesystem::create_directories(work_dir);
+  auto dir = work_dir.string();
+  std::ofstream{work_dir / "a.h"} << "int a();\n";
+  std::ofstream{work_dir / "main.cpp"} << "#include \"a.h\"\nint main() { return a(); }\n";
+
+  SECTION("Compile commands are looked up by absolute path") {
+    auto json = nlohmann::json::array();
+    json.push_back({{"directory", dir}, {"file", "main.cpp"}, {"command", "c++ -c main.cpp"}});
+    json.push_back({{"directory", dir}, {"file", "b.cpp"}, {"arguments", {"c++", "b.cpp"}}});
+    std::ofstream{work_dir / "compile_commands.json"} << json.dump();
+
+    auto database = cache::compile_database::load(dir);
+    REQUIRE(database.has_value());
+    const auto *command = database->find(dir + "/./main.cpp");
+    REQUIRE(command != nullptr);
+    REQUIRE(command->arguments == std::vector<std::string>{"c++", "-c", "main.cpp"});
+    REQUIRE(database->find(dir + "/b.cpp") != nullptr);
+    REQUIRE(database->find(dir + "/c.cpp") == nullptr);
+    REQUIRE_FALSE(cache::compile_database::load(dir + "/missing").has_value());
+  }
+
+  SECTION("Relocated compile commands are saved") {
+    auto json = nlohmann::json::array();
+    json.push_back({{"directory", dir}, {"file", "main.cpp"}, {"command", "c++ -c main.cpp"}});
+    std::ofstream{work_dir / "compile_commands.json"} << json.dump();
+
+    auto relocated = (work_dir / "relocated").string();
+    std::filesystem::create_directories(relocated);
+    cache::compile_database::load(dir)->relocate(dir, relocated, {}).save(relocated);
+    auto database = cache::compile_database::load(relocated);
+    REQUIRE(database.has_value());
+    const auto *command = database->find(relocated + "/main.cpp");
+    REQUIRE(command != nullptr);
+    REQUIRE(command->directory == relocated);
+    REQUIRE(command->arguments == std::vector<std::string>{"c++", "-c", relocated + "/main.cpp"});
+  }
+
+  SECTION("A closure is changed if any file of it changes") {
+    auto hasher  = cache::file_hasher{};
+    auto closure = cache::include_closure{{dir + "/a.h", hasher.hash(dir + "/a.h")},
+                                          {dir + "/main.cpp", hasher.hash(dir + "/main.cpp")}};
+    REQUIRE(cache::is_unchanged(closure, hasher));
+
+    std::ofstream{work_dir / "a.h"} << "int a(int);\n";
+    auto next_run = cache::file_hasher{};
+    REQUIRE_FALSE(cache::is_unchanged(closure, next_run));
+    REQUIRE_FALSE(cache::is_unchanged({{dir + "/missing.h", "0"}}, next_run));
+  }
+
+  SECTION("Included headers are scanned by the compiler") {
+    auto command      = cache::compile_command{};
+    command.directory = dir;
+    command.file      = "main.cpp";
+    command.arguments = {"c++", "-c", "main.cpp", "-o", "main.o", "-MD"};
+    auto hasher       = cache::file_hasher{};
+    auto closure      = cache::scan_include_closure(command, hasher);
+    REQUIRE(closure.has_value());
+    REQUIRE(closure->contains(dir + "/a.h"));
+    REQUIRE(closure->contains(dir + "/main.cpp"));
+    REQUIRE_FALSE(std::filesystem::exists(work_dir / "main.o"));
+  }
+
+  SECTION("Files under the root are recorded relative to it") {
+    auto command      = cache::compile_command{};
+    command.directory = dir;
+    command.file      = "main.cpp";
+    command.arguments = {"c++", "-c", "main.cpp"};
+    auto hasher       = cache::file_hasher{};
+    auto closure      = cache::scan_include_closure(command, hasher, dir);
+    REQUIRE(closure.has_value());
+    REQUIRE(closure->contains("a.h"));
+    REQUIRE(closure->contains("main.cpp"));
+    REQUIRE(cache::is_unchanged(*closure, hasher, dir));
+
+    // The same files written into another directory are unchanged as well.
+    auto copy = work_dir / "copy";
+    std::filesystem::create_directories(copy);
+    std::filesystem::copy_file(work_dir / "a.h", copy / "a.h");
+    std::filesystem::copy_file(work_dir / "main.cpp", copy / "main.cpp");
+    REQUIRE(cache::is_unchanged(*closure, hasher, copy.string()));
+    REQUIRE(cache::hash_preprocessed(command, dir)
+            == cache::hash_preprocessed(cache::relocate(command, dir, copy.string(), {}),
+                                        copy.string()));
+  }
+
+  SECTION("Preprocessed sources change with included files") {
+    auto command      = cache::compile_command{};
+    command.directory = dir;
+    command.file      = "main.cpp";
+    command.arguments = {"c++", "-c", "main.cpp", "-o", "main.o"};
+    auto hash         = cache::hash_preprocessed(command);
+    REQUIRE(hash.has_value());
+    REQUIRE(cache::hash_preprocessed(command) == hash);
+
+    std::ofstream{work_dir / "a.h"} << "#define A 1\nint a();\n";
+    REQUIRE(cache::hash_preprocessed(command) != hash);
+
+    // Suppressions of headers change results of clang-tidy.
+    hash = cache::hash_preprocessed(command);
+    std::ofstream{work_dir / "a.h"} << "#define A 1\nint a(); // NOLINT\n";
+    REQUIRE(cache::hash_preprocessed(command) != hash);
+    REQUIRE_FALSE(std::filesystem::exists(work_dir / "main.o"));
+
+    command.arguments.emplace_back("-DBROKEN=(");
+    std::ofstream{work_dir / "main.cpp"} << "#if BROKEN\n#endif\n";
+    REQUIRE_FALSE(cache::hash_preprocessed(command).has_value());
+  }
+
+  std::filesystem::remove_all(work_dir);
+}
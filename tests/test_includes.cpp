@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/includes.h"
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+TEST_CASE("Test find quoted includes", "[cpp-lint-action][includes]") {
+  SECTION("Quoted includes are found in order") {
+    auto source = "#include \"a.h\"\n#include <vector>\n  #  include \"dir/b.h\" // b\nint n;";
+    REQUIRE(quoted_includes(source) == std::vector<std::string>{"a.h", "dir/b.h"});
+  }
+
+  SECTION("Other lines are skipped") {
+    REQUIRE(quoted_includes("#define A \"a.h\"\n// #include \"b.h\"\n#include \"\"\n").empty());
+    REQUIRE(quoted_includes("").empty());
+  }
+
+  SECTION("CRLF line endings are supported") {
+    REQUIRE(quoted_includes("#include \"a.h\"\r\n") == std::vector<std::string>{"a.h"});
+  }
+}
+
+TEST_CASE("Test find include directives", "[cpp-lint-action][includes]") {
+  auto source   = "#include \"a.h\"\n#include <dir/b.h>\n#include <>\n#include c.h\n";
+  auto includes = find_includes(source);
+  REQUIRE(includes.size() == 2);
+  REQUIRE(includes[0].path == "a.h");
+  REQUIRE(includes[0].quoted);
+  REQUIRE(includes[1].path == "dir/b.h");
+  REQUIRE_FALSE(includes[1].quoted);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/line_index.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "test_common.h"
+
+using namespace lint;
+
+namespace {
+  auto supported_levels() -> std::vector<simd_level> {
+    auto levels = std::vector<simd_level>{simd_level::scalar};
+    auto best   = best_simd_level();
+    if (best != simd_level::scalar) {
+      levels.push_back(simd_level::sse2);
+    }
+    if (best == simd_level::avx2) {
+      levels.push_back(simd_level::avx2);
+    }
+    return levels;
+  }
+
+  auto make_lines(std::size_t num_lines, std::string_view line_feed) -> std::string {
+    auto content = std::string{};
+    for (std::size_t i = 0; i < num_lines; ++i) {
+      content += std::string(i % 97, 'x');
+      content += line_feed;
+    }
+    return content;
+  }
+} // namespace
+
+TEST_CASE("Test find line starts", "[cpp-lint-action][line_index]") {
+  // Longer than a few blocks of every instruction set, with line feeds at
+  // both ends of blocks.
+  auto content = std::string(100, 'a');
+  for (auto pos: {0, 15, 16, 31, 32, 33, 63, 64, 98, 99}) {
+    content[pos] = '\n';
+  }
+  auto expected = std::vector<std::size_t>{0, 1, 16, 17, 32, 33, 34, 64, 65, 99, 100};
+
+  for (auto level: supported_levels()) {
+    REQUIRE(find_line_starts(content, level) == expected);
+    REQUIRE(find_line_starts("", level) == std::vector<std::size_t>{0});
+    REQUIRE(find_line_starts("abc", level) == std::vector<std::size_t>{0});
+  }
+}
+
+TEST_CASE("Test position of line index", "[cpp-lint-action][line_index]") {
+  SECTION("Offsets map to 1-based rows and columns") {
+    auto lines = line_index{"ab\ncd\n"};
+    REQUIRE(lines.num_lines() == 2);
+    REQUIRE(lines.position(0) == std::tuple{1, 1});
+    REQUIRE(lines.position(2) == std::tuple{1, 3});
+    REQUIRE(lines.position(3) == std::tuple{2, 1});
+    REQUIRE(lines.position(5) == std::tuple{2, 3});
+    REQUIRE(lines.position(6) == std::tuple{-1, -1});
+  }
+
+  SECTION("The end of a last line without a line feed is in that line") {
+    auto lines = line_index{"ab\ncd"};
+    REQUIRE(lines.num_lines() == 2);
+    REQUIRE(lines.position(5) == std::tuple{2, 3});
+    REQUIRE(lines.position(6) == std::tuple{-1, -1});
+  }
+
+  SECTION("Carriage returns of CRLF are columns of their lines") {
+    auto lines = line_index{"ab\r\ncd\r\n"};
+    REQUIRE(lines.num_lines() == 2);
+    REQUIRE(lines.position(2) == std::tuple{1, 3});
+    REQUIRE(lines.position(3) == std::tuple{1, 4});
+    REQUIRE(lines.position(4) == std::tuple{2, 1});
+    REQUIRE(lines.position(8) == std::tuple{-1, -1});
+  }
+
+  SECTION("Empty lines and empty buffers") {
+    auto lines = line_index{"\n\n"};
+    REQUIRE(lines.num_lines() == 2);
+    REQUIRE(lines.position(1) == std::tuple{2, 1});
+    REQUIRE(line_index{""}.num_lines() == 0);
+    REQUIRE(line_index{""}.position(0) == std::tuple{-1, -1});
+  }
+}
+
+TEST_CASE("Test map a file", "[cpp-lint-action][line_index]") {
+  create_temp_repo_dir();
+  auto guard = scope_guard{remove_temp_repo_dir};
+
+  create_temp_file("file.cpp", "int a;\r\nint b;\n");
+  create_temp_file("empty.cpp", "");
+  auto file = mapped_file{(get_temp_repo_dir() / "file.cpp").string()};
+  REQUIRE(file.content() == "int a;\r\nint b;\n");
+  REQUIRE(mapped_file{(get_temp_repo_dir() / "empty.cpp").string()}.content().empty());
+  REQUIRE_THROWS(mapped_file{(get_temp_repo_dir() / "missing.cpp").string()});
+}
+
+TEST_CASE("Benchmark line index of a large file", "[.][benchmark][line_index]") {
+  constexpr auto num_lines = std::size_t{200000};
+  auto content             = make_lines(num_lines, "\r\n");
+
+  BENCHMARK("scalar") {
+    return find_line_starts(content, simd_level::scalar).size();
+  };
+  for (auto level: supported_levels()) {
+    if (level == simd_level::sse2) {
+      BENCHMARK("sse2") {
+        return find_line_starts(content, level).size();
+      };
+    } else if (level == simd_level::avx2) {
+      BENCHMARK("avx2") {
+        return find_line_starts(content, level).size();
+      };
+    }
+  }
+
+  auto lines = line_index{content};
+  BENCHMARK("2000 positions") {
+    auto sum = std::int64_t{0};
+    for (std::size_t offset = 0; offset < content.size(); offset += content.size() / 2000) {
+      sum += std::get<0>(lines.position(offset));
+    }
+    return sum;
+  };
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/lsp.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+TEST_CASE("Test LSP message reader splits messages", "[cpp-lint-action][lsp]") {
+  auto first  = nlohmann::json{
+    {"id",     1     },
+    {"result", "done"}
+  };
+  auto second = nlohmann::json{
+    {"method", "exit"}
+  };
+  auto stream = lsp::encode(first) + lsp::encode(second);
+
+  SECTION("Messages fed at once") {
+    auto reader = lsp::message_reader{};
+    reader.feed(stream);
+    REQUIRE(reader.next() == first);
+    REQUIRE(reader.next() == second);
+    REQUIRE(reader.next() == std::nullopt);
+  }
+
+  SECTION("Messages fed byte by byte") {
+    auto reader   = lsp::message_reader{};
+    auto messages = std::vector<nlohmann::json>{};
+    for (auto chr: stream) {
+      reader.feed(std::string_view{&chr, 1});
+      while (auto message = reader.next()) {
+        messages.push_back(*message);
+      }
+    }
+    REQUIRE(messages == std::vector<nlohmann::json>{first, second});
+  }
+
+  SECTION("Other headers are ignored") {
+    auto reader = lsp::message_reader{};
+    reader.feed("Content-Type: application/vscode-jsonrpc\r\nContent-Length: 2\r\n\r\n{}");
+    REQUIRE(reader.next() == nlohmann::json::object());
+  }
+
+  SECTION("Message without Content-Length throws") {
+    auto reader = lsp::message_reader{};
+    reader.feed("Content-Type: application/vscode-jsonrpc\r\n\r\n{}");
+    REQUIRE_THROWS(reader.next());
+  }
+}
+
+TEST_CASE("Test LSP uri converts from and to path", "[cpp-lint-action][lsp]") {
+  REQUIRE(lsp::path_to_uri("/repo/src/main.cpp") == "file:///repo/src/main.cpp");
+  REQUIRE(lsp::path_to_uri("/repo/c++/a b.cpp") == "file:///repo/c%2B%2B/a%20b.cpp");
+  REQUIRE(lsp::uri_to_path("file:///repo/c%2B%2B/a%20b.cpp") == "/repo/c++/a b.cpp");
+  REQUIRE(lsp::uri_to_path(lsp::path_to_uri("/repo/x#y.cpp")) == "/repo/x#y.cpp");
+  REQUIRE_THROWS(lsp::uri_to_path("https://example.com/a.cpp"));
+}
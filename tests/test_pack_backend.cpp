@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/pack_backend.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+
+using namespace lint;
+
+namespace {
+  const auto work_dir = std::filesystem::temp_directory_path() / "test_pack_backend";
+  const auto dir      = work_dir.string();
+
+  auto key_of(int number) -> std::string {
+    return fmt::format("{:040x}", number);
+  }
+} // namespace
+
+TEST_CASE("Test pack backend stores entries", "[cpp-lint-action][pack_backend]") {
+  std::filesystem::remove_all(work_dir);
+
+  SECTION("Entries are kept across runs") {
+    {
+      auto pack = cache::pack_backend{dir, 0};
+      REQUIRE(pack.get(key_of(1)) == std::nullopt);
+      pack.put(key_of(1), "one");
+      pack.put(key_of(2), "two");
+      pack.put(key_of(1), "uno");
+      REQUIRE(pack.get(key_of(1)) == "uno");
+      REQUIRE(pack.count() == 2);
+    }
+    auto pack = cache::pack_backend{dir, 0};
+    REQUIRE(pack.get(key_of(1)) == "uno");
+    REQUIRE(pack.get(key_of(2)) == "two");
+    REQUIRE(pack.get(key_of(3)) == std::nullopt);
+  }
+
+  SECTION("Malformed keys are ignored") {
+    auto pack = cache::pack_backend{dir, 0};
+    pack.put("abc", "value");
+    REQUIRE(pack.get("abc") == std::nullopt);
+    REQUIRE(pack.count() == 0);
+  }
+
+  SECTION("The index grows with entries") {
+    auto pack = cache::pack_backend{dir, 0};
+    for (int i = 0; i < 3000; ++i) {
+      pack.put(key_of(i), std::to_string(i));
+    }
+    REQUIRE(pack.count() == 3000);
+    for (int i = 0; i < 3000; ++i) {
+      REQUIRE(pack.get(key_of(i)) == std::to_string(i));
+    }
+  }
+
+  SECTION("A lost index is rebuilt from the pack") {
+    {
+      auto pack = cache::pack_backend{dir, 0};
+      pack.put(key_of(1), "one");
+      pack.put(key_of(2), "two");
+    }
+    std::filesystem::remove(work_dir / "results.idx");
+    // A torn record left by an interrupted write is dropped.
+    std::ofstream{work_dir / "results.pack", std::ios::app | std::ios::binary} << "torn";
+
+    auto pack = cache::pack_backend{dir, 0};
+    REQUIRE(pack.count() == 2);
+    REQUIRE(pack.get(key_of(1)) == "one");
+    REQUIRE(pack.get(key_of(2)) == "two");
+    pack.put(key_of(3), "three");
+    REQUIRE(pack.get(key_of(3)) == "three");
+  }
+
+  SECTION("A pack is used by one user at a time") {
+    auto pack = cache::pack_backend{dir, 0};
+    pack.put(key_of(1), "one");
+    auto other = cache::pack_backend{dir, 0};
+    REQUIRE(other.get(key_of(1)) == std::nullopt);
+    other.put(key_of(2), "two");
+    REQUIRE(pack.get(key_of(2)) == std::nullopt);
+  }
+
+  std::filesystem::remove_all(work_dir);
+}
+
+TEST_CASE("Test pack backend compaction", "[cpp-lint-action][pack_backend]") {
+  std::filesystem::remove_all(work_dir);
+  const auto value = std::string(1000, 'x');
+
+  SECTION("Garbage of replaced entries is dropped") {
+    auto pack = cache::pack_backend{dir, 0};
+    pack.put(key_of(1), value);
+    pack.put(key_of(1), value);
+    auto before = pack.size();
+    pack.compact();
+    REQUIRE(pack.size() < before);
+    REQUIRE(pack.get(key_of(1)) == value);
+  }
+
+  SECTION("Least recently used entries are evicted beyond the size cap") {
+    {
+      auto pack = cache::pack_backend{dir, 10 * 1024};
+      for (int i = 0; i < 20; ++i) {
+        pack.put(key_of(i), value);
+      }
+      // Entries are stamped by seconds, so wait to make the access newer.
+      std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+      REQUIRE(pack.get(key_of(0)) == value);
+    }
+
+    auto pack = cache::pack_backend{dir, 10 * 1024};
+    REQUIRE(pack.size() <= 10 * 1024);
+    REQUIRE(pack.count() < 20);
+    REQUIRE(pack.get(key_of(0)) == value);
+  }
+
+  std::filesystem::remove_all(work_dir);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/pathspec.h"
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+TEST_CASE("Test translate file filters into globs", "[cpp-lint-action][pathspec]") {
+  SECTION("Extension groups become case insensitive globs") {
+    auto globs = iregex_to_globs(R"(.*\.(cpp|h|c\+\+))");
+    REQUIRE(globs.has_value());
+    REQUIRE(*globs == std::vector<std::string>{"*.[cC][pP][pP]", "*.[hH]", "*.[cC]++"});
+  }
+
+  SECTION("A single extension is supported") {
+    REQUIRE(iregex_to_globs(R"(.*\.test)") == std::vector<std::string>{"*.[tT][eE][sS][tT]"});
+  }
+
+  SECTION("The default file filter is supported") {
+    auto globs = iregex_to_globs(R"(.*\.(cpp|cc|c\+\+|cxx|c|cl|h|hpp|m|mm|inc))");
+    REQUIRE(globs.has_value());
+    REQUIRE(globs->size() == 11);
+  }
+
+  SECTION("Other regexes can't be translated") {
+    REQUIRE(iregex_to_globs(R"(src/.*\.cpp)") == std::nullopt);
+    REQUIRE(iregex_to_globs(R"(.*\.cpp|.*\.h)") == std::nullopt);
+    REQUIRE(iregex_to_globs(R"(.*\.(cpp|h)?)") == std::nullopt);
+    REQUIRE(iregex_to_globs(R"(.*\.[ch]pp)") == std::nullopt);
+    REQUIRE(iregex_to_globs(R"(.*\.)") == std::nullopt);
+  }
+}
+
+TEST_CASE("Test make pathspec of includes and excludes", "[cpp-lint-action][pathspec]") {
+  SECTION("Nothing given matches all paths") {
+    REQUIRE(make_pathspec({}, {}).empty());
+  }
+
+  SECTION("Excludes are placed before includes") {
+    auto pathspec = make_pathspec({"src/*", "*.h"}, {"third_party/*"});
+    REQUIRE(pathspec == std::vector<std::string>{"!third_party/*", "src/*", "*.h"});
+  }
+
+  SECTION("Other paths are matched if only excludes are given") {
+    auto pathspec = make_pathspec({}, {"third_party/*"});
+    REQUIRE(pathspec == std::vector<std::string>{"!third_party/*", "*"});
+  }
+}
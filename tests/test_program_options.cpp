@@ -14,10 +14,15 @@
  * limitations under the License.
  */
 
+#include "cache/pack_backend.h"
 #include "github/common.h"
 #include "program_options.h"
 #include "utils/env_manager.h"
 
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_test_macros.hpp>
 
@@ -111,5 +116,56 @@ TEST_CASE("Test fill context by program options", "[cpp-lint-action][program_opt
     REQUIRE(context.enable_comment_on_issue == true);
     REQUIRE(context.enable_pull_request_review == false);
     REQUIRE(context.enable_action_output == true);
+    REQUIRE(context.jobs >= 1);
+  }
+
+  SECTION("jobs should be passed into context") {
+    auto opts         = make_opt("--target-revision=main", "--jobs=4");
+    auto user_options = parse(opts.size(), opts.data(), desc);
+    REQUIRE_NOTHROW(fill_context(user_options, context));
+    REQUIRE(context.jobs == 4);
+  }
+
+  SECTION("zero jobs should throw exception") {
+    auto opts         = make_opt("--target-revision=main", "--jobs=0");
+    auto user_options = parse(opts.size(), opts.data(), desc);
+    REQUIRE_THROWS(fill_context(user_options, context));
+  }
+}
+
+TEST_CASE("Test compact caches without target revision", "[cpp-lint-action][program_options]") {
+  const auto cache_dir = std::filesystem::temp_directory_path() / "test_cache_compact";
+  const auto results   = cache_dir / "results";
+  const auto pack      = (results / "clang-format").string();
+  const auto key       = std::string(40, '0');
+  std::filesystem::remove_all(cache_dir);
+
+  // Options of `cpp-lint-action cache compact`.
+  auto dir_opt      = "--cache-dir=" + cache_dir.string();
+  auto desc         = create_desc();
+  auto context      = runtime_context{};
+  auto opts         = make_opt(dir_opt.c_str(), "--result-cache-max-size=1");
+  auto user_options = parse(opts.size(), opts.data(), desc);
+  REQUIRE_THROWS(fill_context(user_options, context));
+  REQUIRE_NOTHROW(fill_cache_context(user_options, context));
+  REQUIRE(context.cache_dir == cache_dir.string());
+  REQUIRE(context.result_cache_max_size == 1024 * 1024);
+
+  // Nothing is cached yet.
+  REQUIRE_NOTHROW(cache::compact_packs(results.string(), context.result_cache_max_size));
+
+  auto before = std::uint64_t{0};
+  {
+    auto backend = cache::pack_backend{pack, 0};
+    backend.put(key, "a");
+    backend.put(key, "b");
+    before = backend.size();
+  }
+  cache::compact_packs(results.string(), context.result_cache_max_size);
+  {
+    auto backend = cache::pack_backend{pack, 0};
+    REQUIRE(backend.size() < before);
+    REQUIRE(backend.get(key) == "b");
   }
+  std::filesystem::remove_all(cache_dir);
 }
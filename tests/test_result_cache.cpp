@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cache/result_cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "tools/clang_format/general/result.h"
+#include "tools/clang_tidy/general/result.h"
+#include "tools/util.h"
+
+using namespace lint;
+
+namespace {
+  const auto cache_dir = std::filesystem::temp_directory_path() / "test_result_cache";
+} // namespace
+
+TEST_CASE("Test result cache key builder", "[cpp-lint-action][result_cache]") {
+  auto key = cache::key_builder{}.add("clang-format").add("18").build();
+  REQUIRE(key.size() == 40);
+  REQUIRE(key == cache::key_builder{}.add("clang-format").add("18").build());
+  REQUIRE(key != cache::key_builder{}.add("clang-format").add("19").build());
+  // Parts are length prefixed, so moving bytes between parts changes the key.
+  REQUIRE(cache::key_builder{}.add("ab").add("c").build()
+          != cache::key_builder{}.add("a").add("bc").build());
+}
+
+TEST_CASE("Test result cache stores json values", "[cpp-lint-action][result_cache]") {
+  std::filesystem::remove_all(cache_dir);
+  auto cache = cache::result_cache{cache_dir.string()};
+  auto key   = cache::key_builder{}.add("main.cpp").build();
+
+  SECTION("A missing entry is a miss") {
+    REQUIRE(cache.get(key) == std::nullopt);
+  }
+
+  SECTION("A stored entry is returned") {
+    cache.put(key, nlohmann::json{{"passed", true}});
+    auto value = cache.get(key);
+    REQUIRE(value.has_value());
+    REQUIRE((*value)["passed"] == true);
+  }
+
+  SECTION("A broken entry is a miss") {
+    cache.put(key, nlohmann::json{{"passed", true}});
+    std::ofstream{cache_dir / key.substr(0, 2) / (key.substr(2) + ".json")} << "{";
+    REQUIRE(cache.get(key) == std::nullopt);
+  }
+
+  SECTION("Results of clang-format are restored") {
+    auto result        = tool::clang_format::per_file_result{};
+    result.passed      = false;
+    result.file_path   = "main.cpp";
+    result.file_option = "--output-replacements-xml main.cpp";
+    result.replacements[3].push_back({.offset = 10, .length = 1, .data = " ", .row = 3, .col = 2});
+    cache.put(key, result);
+
+    auto restored = cache.get(key)->get<tool::clang_format::per_file_result>();
+    REQUIRE(restored.passed == false);
+    REQUIRE(restored.file_path == "main.cpp");
+    REQUIRE(restored.file_option == result.file_option);
+    REQUIRE(restored.replacements.at(3).size() == 1);
+    REQUIRE(restored.replacements.at(3)[0].offset == 10);
+    REQUIRE(restored.replacements.at(3)[0].data == " ");
+  }
+
+  SECTION("Results of clang-tidy are restored") {
+    auto result                    = tool::clang_tidy::per_file_result{};
+    result.passed                  = false;
+    result.file_path               = "main.cpp";
+    result.stat.warnings           = 1;
+    auto &diag                     = result.diags.emplace_back();
+    diag.header.file_name          = "/repo/main.cpp";
+    diag.header.serverity          = "error";
+    diag.header.checks             = "bugprone-use-after-move";
+    diag.details                   = "  10 | use(x);";
+    auto value                     = nlohmann::json(result);
+    value["includes"]["/repo/a.h"] = "0123";
+    cache.put(key, value);
+
+    auto restored = cache.get(key)->get<tool::clang_tidy::per_file_result>();
+    REQUIRE(restored.stat.warnings == 1);
+    REQUIRE(restored.diags.size() == 1);
+    REQUIRE(restored.diags[0].header.checks == "bugprone-use-after-move");
+    REQUIRE(restored.diags[0].details == diag.details);
+  }
+
+  SECTION("A cached result which fails validation is a miss") {
+    auto result      = tool::clang_format::per_file_result{};
+    result.passed    = true;
+    result.file_path = "main.cpp";
+    cache.put(key, result);
+
+    using results_t = std::vector<std::optional<tool::clang_format::per_file_result>>;
+    auto keys       = std::vector<std::optional<std::string>>{key};
+    auto results    = results_t(1);
+    auto summary    = tool::clang_format::result_t{};
+    auto throwing   = [](const nlohmann::json &value) {
+      return value.at("includes").empty();
+    };
+    REQUIRE(tool::lookup_cached_results(cache, keys, results, summary, throwing)
+            == std::vector<std::size_t>{0});
+    REQUIRE_FALSE(results[0].has_value());
+    REQUIRE(summary.cache_misses == 1);
+
+    auto accepting = [](const nlohmann::json &) { return true; };
+    REQUIRE(tool::lookup_cached_results(cache, keys, results, summary, accepting).empty());
+    REQUIRE(results[0]->file_path == "main.cpp");
+    REQUIRE(summary.cache_hits == 1);
+  }
+
+  std::filesystem::remove_all(cache_dir);
+}
+
+TEST_CASE("Test finding the nearest config file", "[cpp-lint-action][result_cache]") {
+  std::filesystem::remove_all(cache_dir);
+  std::filesystem::create_directories(cache_dir / "src" / "sub");
+  std::ofstream{cache_dir / ".clang-format"} << "root";
+  std::ofstream{cache_dir / "src" / "_clang-format"} << "src";
+
+  auto root  = cache_dir.string();
+  REQUIRE(cache::nearest_config(root, "main.cpp", {".clang-format", "_clang-format"}) == "root");
+  REQUIRE(cache::nearest_config(root, "src/sub/a.cpp", {".clang-format", "_clang-format"})
+          == "src");
+  REQUIRE(cache::nearest_config(root, "src/sub/a.cpp", {".clang-tidy"}).empty());
+  REQUIRE(cache::config_chain(root, "src/sub/a.cpp", {".clang-format", "_clang-format"})
+          == std::vector<std::string>{"src", "root"});
+
+  std::filesystem::remove_all(cache_dir);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/shell.h"
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+namespace {
+  constexpr auto sh = "/bin/sh";
+} // namespace
+
+TEST_CASE("Test execute collects outputs and exit code", "[cpp-lint-action][shell]") {
+  auto res = shell::execute(sh, {"-c", "echo out; echo err >&2; exit 3"});
+  REQUIRE(res.exit_code == 3);
+  REQUIRE(res.std_out == "out\n");
+  REQUIRE(res.std_err == "err\n");
+}
+
+TEST_CASE("Test execute in the given directory with environment", "[cpp-lint-action][shell]") {
+  auto env = shell::envrionment{
+    {"LINT_VALUE", "42"}
+  };
+  auto res = shell::execute(sh, {"-c", "pwd; echo $LINT_VALUE"}, env, "/");
+  REQUIRE(res.exit_code == 0);
+  REQUIRE(res.std_out == "/\n42\n");
+}
+
+TEST_CASE("Test async execute runs children concurrently", "[cpp-lint-action][shell]") {
+  auto futures = std::vector<std::future<shell::result>>{};
+  for (int i = 0; i < 32; ++i) {
+    futures.push_back(shell::async_execute(sh, {"-c", "sleep 0.2; echo $0", std::to_string(i)}));
+  }
+  for (int i = 0; i < 32; ++i) {
+    auto res = futures[i].get();
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.std_out == std::to_string(i) + "\n");
+  }
+}
+
+TEST_CASE("Test execute drains stdout and stderr concurrently", "[cpp-lint-action][shell]") {
+  // The stub floods stderr before writing stdout, and then interleaves them
+  // with 8 MiB each time. This hangs if stdout is read to the end before
+  // stderr is read.
+  constexpr auto stub = "head -c 8388608 /dev/zero >&2;"
+                        "for i in 1 2 3 4; do"
+                        "  head -c 8388608 /dev/zero;"
+                        "  head -c 8388608 /dev/zero >&2;"
+                        "done";
+  constexpr auto size = std::size_t{8388608};
+
+  auto res = shell::execute(sh, {"-c", stub});
+  REQUIRE(res.exit_code == 0);
+  REQUIRE(res.std_out.size() == 4 * size);
+  REQUIRE(res.std_err.size() == 5 * size);
+}
+
+TEST_CASE("Test process group kills its running children", "[cpp-lint-action][shell]") {
+  auto group   = shell::process_group{};
+  auto start   = std::chrono::steady_clock::now();
+  auto running = group.async_execute(sh, {"-c", "sleep 30"}, "/");
+  auto other   = shell::async_execute(sh, {"-c", "sleep 0.5"});
+  group.kill();
+
+  REQUIRE(group.killed());
+  REQUIRE(running.get().exit_code != 0);
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds{10});
+
+  // Children out of the group aren't affected, and later ones aren't started.
+  REQUIRE(other.get().exit_code == 0);
+  REQUIRE(group.execute(sh, {"-c", "exit 0"}, "/").exit_code == -1);
+}
+
+TEST_CASE("Test execute throws if command doesn't exist", "[cpp-lint-action][shell]") {
+  REQUIRE_THROWS(shell::execute("/not/exist/command", {}));
+}
+
+TEST_CASE("Test which finds commands in PATH", "[cpp-lint-action][shell]") {
+  SECTION("A command is resolved to its full path") {
+    auto res = shell::which("sh");
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(std::filesystem::path{res.std_out}.filename() == "sh");
+    REQUIRE(std::filesystem::path{res.std_out}.is_absolute());
+  }
+
+  SECTION("A command with a slash isn't searched in PATH") {
+    REQUIRE(shell::which(sh).std_out == sh);
+    REQUIRE(shell::which("/not/exist/command").exit_code != 0);
+  }
+
+  SECTION("A missing command fails") {
+    REQUIRE(shell::which("cpp-lint-action-not-exist-command").exit_code != 0);
+  }
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/thread_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+TEST_CASE("Test thread pool runs all submitted tasks", "[cpp-lint-action][thread_pool]") {
+  auto counter = std::atomic<int>{0};
+  auto pool    = thread_pool{4};
+  for (int i = 0; i < 100; ++i) {
+    pool.submit([&] { ++counter; });
+  }
+  pool.wait();
+  REQUIRE(counter == 100);
+}
+
+TEST_CASE("Test thread pool rethrows task exception", "[cpp-lint-action][thread_pool]") {
+  auto pool = thread_pool{2};
+  pool.submit([] { throw std::runtime_error{"task failed"}; });
+  REQUIRE_THROWS(pool.wait());
+}
+
+TEST_CASE("Test usable cpu count", "[cpp-lint-action][thread_pool]") {
+  REQUIRE(usable_cpu_count() >= 1);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 Emmett Zhang
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/version_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace lint;
+
+namespace {
+  const auto store_dir  = std::filesystem::temp_directory_path() / "test_version_cache";
+  const auto store_file = (store_dir / "versions.json").string();
+  const auto binary     = (store_dir / "fake-tool").string();
+  const auto counter    = (store_dir / "probes").string();
+
+  // A fake tool which counts how many times its version is probed.
+  void write_fake_tool(const std::string &version) {
+    {
+      auto file = std::ofstream{binary};
+      file << "#!/bin/sh\n"
+           << "echo probed >> " << counter << "\n"
+           << "echo 'fake version " << version << "'\n";
+    }
+    std::filesystem::permissions(binary,
+                                 std::filesystem::perms::owner_all,
+                                 std::filesystem::perm_options::add);
+  }
+
+  auto num_probes() -> std::size_t {
+    auto file  = std::ifstream{counter};
+    auto line  = std::string{};
+    auto count = std::size_t{0};
+    while (std::getline(file, line)) {
+      ++count;
+    }
+    return count;
+  }
+} // namespace
+
+TEST_CASE("Test version cache probes each binary once", "[cpp-lint-action][version_cache]") {
+  std::filesystem::remove_all(store_dir);
+  std::filesystem::create_directories(store_dir);
+  write_fake_tool("18.1.3");
+
+  SECTION("A probed version is reused by later runs") {
+    auto versions = version_cache{store_file};
+    REQUIRE(versions.probe(binary) == "fake version 18.1.3\n");
+    REQUIRE(versions.probe(binary) == "fake version 18.1.3\n");
+    versions.save();
+
+    auto loaded = version_cache{store_file};
+    REQUIRE(loaded.probe(binary) == "fake version 18.1.3\n");
+    REQUIRE(num_probes() == 1);
+  }
+
+  SECTION("A replaced binary is probed again") {
+    auto versions = version_cache{store_file};
+    REQUIRE(versions.probe(binary) == "fake version 18.1.3\n");
+    versions.save();
+
+    std::filesystem::remove(binary);
+    write_fake_tool("19.1.10");
+    auto loaded = version_cache{store_file};
+    REQUIRE(loaded.probe(binary) == "fake version 19.1.10\n");
+    REQUIRE(num_probes() == 2);
+  }
+
+  SECTION("A failed probe isn't cached") {
+    auto failed = (store_dir / "failed-tool").string();
+    std::ofstream{failed} << "#!/bin/sh\nexit 1\n";
+    std::filesystem::permissions(failed, std::filesystem::perms::owner_all);
+    auto versions = version_cache{store_file};
+    REQUIRE(versions.probe(failed) == std::nullopt);
+    versions.save();
+    REQUIRE_FALSE(std::filesystem::exists(store_file));
+  }
+
+  SECTION("A broken store file is treated as empty") {
+    std::ofstream{store_file} << "not a json";
+    auto versions = version_cache{store_file};
+    REQUIRE(versions.probe(binary) == "fake version 18.1.3\n");
+    versions.save();
+    REQUIRE(version_cache{store_file}.probe(binary) == "fake version 18.1.3\n");
+    REQUIRE(num_probes() == 1);
+  }
+
+  std::filesystem::remove_all(store_dir);
+}